@@ -6,8 +6,12 @@
 #include "reporters/AvgStatsReporter.hpp"
 #include "reporters/CorrectnessReporter.hpp"
 #include "reporters/StructReporter.hpp"
+#include "reporters/MemoryReporter.hpp"
 #include "reporters/PapiReporter.hpp"
 #include "reporters/PerfReporter.hpp"
+#include "reporters/ThroughputReporter.hpp"
+#include "reporters/KnnReporter.hpp"
+#include "reporters/PredicateReporter.hpp"
 
 namespace Bench
 {
@@ -97,6 +101,9 @@ std::shared_ptr<Reporter> ReporterArg::createReporter(
 	if (name == "struct") {
 		return std::make_shared<StructReporter>();
 	}
+	if (name == "memory") {
+		return std::make_shared<MemoryReporter>();
+	}
 
 	if (arguments.size() < 1) {
 		throw std::runtime_error("Too few arguments for reporter");
@@ -148,6 +155,56 @@ std::shared_ptr<Reporter> ReporterArg::createReporter(
 
 	}
 
+	if (name == "throughput") {
+		std::vector<unsigned> threads;
+
+		for (auto it = arguments.begin() + 1; it != arguments.end(); ++it) {
+			threads.push_back(std::stoul(*it));
+		}
+
+		return std::make_shared<ThroughputReporter>(arguments[0], threads);
+	}
+
+	if (name == "knn") {
+		return std::make_shared<KnnReporter>(
+				arguments[0],
+				arguments.size() > 1 ? std::stoul(arguments[1]) : 10
+			);
+	}
+
+	if (name == "contains") {
+		return std::make_shared<PredicateReporter>(
+				arguments[0],
+				Query::Type::CONTAINS
+			);
+	}
+
+	if (name == "within") {
+		return std::make_shared<PredicateReporter>(
+				arguments[0],
+				Query::Type::WITHIN
+			);
+	}
+
+	if (name == "stab") {
+		return std::make_shared<PredicateReporter>(
+				arguments[0],
+				Query::Type::STAB
+			);
+	}
+
+	if (name == "radius") {
+		if (arguments.size() < 2) {
+			throw std::runtime_error("Too few arguments for reporter");
+		}
+
+		return std::make_shared<PredicateReporter>(
+				arguments[0],
+				Query::Type::RADIUS,
+				std::stod(arguments[1])
+			);
+	}
+
 	if (name == "perf") {
 		return std::make_shared<PerfReporter>(
 				arguments[0],
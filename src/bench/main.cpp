@@ -5,14 +5,69 @@
 #include "Logger.hpp"
 #include "DynamicObject.hpp"
 #include "reporters/ProgressLogger.hpp"
+#include "reporters/JoinReporter.hpp"
 #include "spatial/InvalidStructureError.hpp"
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <omp.h>
 #include <tclap/CmdLine.h>
 
 using namespace Bench;
 using namespace Spatial;
 
+
+/**
+ * Index a data set, either by bulk loading or one object at a time.
+ *
+ * @param index Index to build
+ * @param dataSet Data set to index
+ * @param filename File name of the data set (for logging)
+ * @param bulkLoad Whether to bulk load the data set
+ * @param logger Logger to report progress to
+ * @return Time spent building the index
+ */
+std::chrono::steady_clock::duration build(
+		SpatialIndex& index,
+		LazyDataSet& dataSet,
+		const std::string& filename,
+		bool bulkLoad,
+		Logger& logger
+	)
+{
+	const unsigned long long objectCount = dataSet.getSize();
+
+	if (bulkLoad) {
+		logger.endStart("Reading data from " + filename);
+		ProgressLogger progress (std::clog, objectCount);
+		std::vector<DataObject> objects;
+		objects.reserve(objectCount);
+
+		for (const DataObject& object : dataSet) {
+			objects.push_back(object);
+			progress.increment();
+		}
+
+		logger.endStart("Bulk loading data");
+		auto startTime = std::chrono::steady_clock::now();
+		index.bulkLoad(objects);
+		return std::chrono::steady_clock::now() - startTime;
+	}
+
+	logger.endStart("Inserting data from " + filename);
+	ProgressLogger progress (std::clog, objectCount);
+	auto startTime = std::chrono::steady_clock::now();
+
+	for (const DataObject& object : dataSet) {
+		index.insert(object);
+		progress.increment();
+	}
+
+	return std::chrono::steady_clock::now() - startTime;
+}
+
+
 int main(int argc, char *argv[])
 {
 
@@ -33,39 +88,76 @@ int main(int argc, char *argv[])
 			true, "", "data set file", cmd
 		);
 
+	TCLAP::SwitchArg bulkLoad (
+			"b", "bulk-load",
+			"Bulk load the data set instead of inserting one object at a time.",
+			cmd
+		);
+
+	TCLAP::ValueArg<unsigned> threads (
+			"j", "threads",
+			"Number of threads used by parallel indexes (defaults to all cores).",
+			false, 0, "threads", cmd
+		);
+
+	TCLAP::ValueArg<std::string> joinFilename (
+			"", "join",
+			"Index a second data set the same way and report the throughput "
+			"of joining the two (in pairs/s).",
+			false, "", "data set file", cmd
+		);
+
+	TCLAP::ValueArg<double> joinDistance (
+			"", "join-distance",
+			"Join the objects within this distance of each other, instead of "
+			"the intersecting ones.",
+			false, 0.0, "distance", cmd
+		);
+
 	ReporterArg reporters (
 			"reporter",
 			"Generate a report in the give style.",
-			true, "reporter definition(s)", cmd
+			false, "reporter definition(s)", cmd
 		);
 
 	cmd.parse(argc, argv);
 
+	if (reporters.getValue().empty() && !joinFilename.isSet()) {
+		std::cerr << C::red("Nothing to do: ")
+			<< "Give a reporter or a data set to join with" << std::endl;
+		return 1;
+	}
+
 
 	try {
 		std::string filename = dataFilename.getValue();
 
+		if (threads.getValue()) {
+			omp_set_num_threads(threads.getValue());
+		}
+
 		logger.endStart("Preparing to run " + algorithm.getName());
 
 		// Load benchmark data
 		logger.start("Opening data set " + filename);
 		LazyDataSet dataSet (filename);
+		const unsigned long long objectCount = dataSet.getSize();
 
 		// Create index
 		DynamicObject<SpatialIndex, const Box&, unsigned long long> index (
 				"./lib" + algorithm.getValue() + ".so",
 				dataSet.begin().getBounds(),
-				dataSet.getSize()
+				objectCount
 			);
 
 		// Index data
-		logger.endStart("Inserting data from " + filename);
-		ProgressLogger progress (std::clog, dataSet.getSize());
-
-		for (const DataObject& object : dataSet) {
-			index->insert(object);
-			progress.increment();
-		}
+		std::chrono::steady_clock::duration buildTime = build(
+				*index,
+				dataSet,
+				filename,
+				bulkLoad.getValue(),
+				logger
+			);
 
 		logger.endStart("Preparing for search");
 		index->prepare();
@@ -78,13 +170,53 @@ int main(int argc, char *argv[])
 			return 1;
 		}
 
+		std::vector<std::shared_ptr<Reporter>> runs (
+				reporters.begin(),
+				reporters.end()
+			);
+
+		// Index the data set to join with the same way
+		std::shared_ptr<SpatialIndex> other;
+
+		if (joinFilename.isSet()) {
+			logger.endStart("Opening data set " + joinFilename.getValue());
+			LazyDataSet joinSet (joinFilename.getValue());
+
+			other = DynamicObject<SpatialIndex, const Box&, unsigned long long>(
+					"./lib" + algorithm.getValue() + ".so",
+					joinSet.begin().getBounds(),
+					joinSet.getSize()
+				);
+
+			build(
+					*other,
+					joinSet,
+					joinFilename.getValue(),
+					bulkLoad.getValue(),
+					logger
+				);
+			other->prepare();
+			runs.push_back(std::make_shared<JoinReporter>(
+					*other,
+					joinDistance.getValue(),
+					5
+				));
+		}
+
 		logger.end();
 
 		// Benchmark
 		logger.start("Generating reports");
 
-		for (auto reporter : reporters) {
+		for (auto reporter : runs) {
 			logger.endStart("Running reporter...");
+			reporter->setBuildStats(
+					std::chrono::duration_cast<std::chrono::microseconds>(
+							buildTime
+						),
+					objectCount,
+					omp_get_max_threads()
+				);
 			reporter->run(*index, std::clog);
 		}
 
@@ -92,7 +224,7 @@ int main(int argc, char *argv[])
 
 		// Output reports
 		logger.endStart("Generating report");
-		for (auto reporter : reporters) {
+		for (auto reporter : runs) {
 			std::cout << reporter << std::endl;
 		}
 
@@ -0,0 +1,48 @@
+#include "JoinReporter.hpp"
+#include "ProgressLogger.hpp"
+#include <algorithm>
+
+namespace Bench
+{
+
+JoinReporter::JoinReporter(
+		const SpatialIndex& other,
+		double distance,
+		unsigned runs
+	)
+	: other(other), distance(distance), runs(runs)
+{
+}
+
+
+void JoinReporter::run(
+		const SpatialIndex& index,
+		std::ostream& logStream
+	)
+{
+	ProgressLogger progress(logStream, runs);
+
+	for (unsigned i = 0; i < runs; ++i) {
+		clearCache();
+
+		CountingPairSink sink;
+		auto startTime = clock::now();
+		index.join(sink, other, distance);
+		auto endTime = clock::now();
+
+		unsigned long long runtime =
+			std::chrono::duration_cast<period>(endTime - startTime).count();
+
+		addEntry("join_runtime", runtime);
+		addEntry("join_pairs", sink.getCount());
+		addEntry(
+				"join_throughput",
+				sink.getCount() * 1e6 / std::max<unsigned long long>(runtime, 1)
+			);
+
+		increment();
+		progress.increment();
+	}
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "RunTimeReporter.hpp"
+#include "MetricReporter.hpp"
+
+namespace Bench
+{
+
+/**
+ * Reports the run time and throughput of joining the index with another.
+ *
+ * The pairs of objects within a distance of each other are joined, which
+ * are the intersecting pairs for a distance of 0. The pairs are only
+ * counted, thus never materialized. For each run, the
+ * report contains the run time, the number of pairs and the throughput in
+ * pairs per second.
+ */
+class JoinReporter : public MetricReporter<double>, private RunTimeReporter
+{
+	public:
+
+		/**
+		 * @param other Index to join with, which must outlive the reporter
+		 * @param distance Maximum distance between the objects of a pair
+		 * @param runs Number of times to run the join
+		 */
+		JoinReporter(
+				const SpatialIndex& other,
+				double distance,
+				unsigned runs
+			);
+
+		void run(
+				const SpatialIndex& index,
+				std::ostream& logStream
+			) override;
+
+	private:
+		const SpatialIndex& other;
+		double distance;
+		unsigned runs;
+};
+
+}
@@ -0,0 +1,68 @@
+#include "KnnReporter.hpp"
+#include "ProgressLogger.hpp"
+#include "spatial/KnnQuery.hpp"
+#include "spatial/StatsCollector.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace Bench
+{
+
+KnnReporter::KnnReporter(const std::string& queryPath, unsigned k)
+	: QueryReporter(queryPath), k(k)
+{
+}
+
+
+void KnnReporter::run(
+		const SpatialIndex& index,
+		std::ostream& logStream
+	)
+{
+	auto queries = getQuerySet();
+	ProgressLogger progress(logStream, queries.getSize());
+
+	for (auto query : queries) {
+		const auto& points = query.getBox().getPoints();
+		Point center (points.first.getDimension());
+
+		for (unsigned d = 0; d < center.getDimension(); ++d) {
+			center[d] = (points.first[d] + points.second[d]) / 2.0;
+		}
+
+		KnnQuery knn (k, center);
+		unsigned long min = std::numeric_limits<unsigned long>::max();
+
+		for (unsigned run = 0; run < RUNS; ++run) {
+			clearCache();
+			Results results;
+			results.reserve(k);
+
+			// Time task
+			auto startTime = clock::now();
+			index.search(results, knn);
+			auto endTime = clock::now();
+
+			min = std::min<unsigned long>(
+					min,
+					std::chrono::duration_cast<std::chrono::microseconds>(
+							endTime - startTime
+						).count()
+				);
+		}
+
+		addEntry("query_runtime", min);
+
+		// Count visited nodes in a separate, instrumented search
+		StatsCollector stats;
+		index.search(stats, knn);
+
+		for (auto stat : stats) {
+			addEntry(stat.first, stat.second);
+		}
+
+		progress.increment();
+	}
+}
+
+}
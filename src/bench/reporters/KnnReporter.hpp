@@ -0,0 +1,39 @@
+#pragma once
+#include "RunTimeReporter.hpp"
+#include "QueryReporter.hpp"
+
+namespace Bench
+{
+
+/**
+ * Reports the run time and node accesses of k-NN queries.
+ *
+ * Query sets only hold boxes, thus the center of each box is used as the
+ * query point.
+ */
+class KnnReporter : public QueryReporter, private RunTimeReporter
+{
+	public:
+
+		/**
+		 * @param queryPath Path to query set
+		 * @param k Number of neighbours to search for
+		 */
+		KnnReporter(const std::string& queryPath, unsigned k);
+
+		void run(
+				const SpatialIndex& index,
+				std::ostream& logStream
+			) override;
+
+	protected:
+		/**
+		 * Number of runs to take the minimum run time of.
+		 */
+		static const unsigned RUNS = 5;
+
+	private:
+		unsigned k;
+};
+
+}
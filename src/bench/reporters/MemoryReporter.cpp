@@ -0,0 +1,15 @@
+#include "MemoryReporter.hpp"
+
+namespace Bench
+{
+
+void MemoryReporter::run(const SpatialIndex& index, std::ostream& logStream)
+{
+	StatsCollector stats = index.collectMemoryStatistics();
+
+	for (auto s : stats) {
+		addEntry(s.first, s.second);
+	}
+}
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "MetricReporter.hpp"
+
+namespace Bench
+{
+
+/**
+ * Reports on the memory held by an index.
+ */
+class MemoryReporter : public MetricReporter<unsigned long long>
+{
+	public:
+
+		void run(
+				const SpatialIndex& index,
+				std::ostream& logStream
+			) override;
+
+};
+
+}
@@ -0,0 +1,110 @@
+#include "PredicateReporter.hpp"
+#include "ProgressLogger.hpp"
+#include "spatial/ContainsQuery.hpp"
+#include "spatial/WithinQuery.hpp"
+#include "spatial/StabbingQuery.hpp"
+#include "spatial/RadiusQuery.hpp"
+#include "spatial/StatsCollector.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace Bench
+{
+
+PredicateReporter::PredicateReporter(
+		const std::string& queryPath,
+		Query::Type type,
+		double radius
+	) : QueryReporter(queryPath), type(type), radius(radius)
+{
+	if (type == Query::Type::RANGE || type == Query::Type::KNN) {
+		throw std::invalid_argument(
+				"Not a containment, stabbing or radius query"
+			);
+	}
+
+	if (radius < 0.0) {
+		throw std::invalid_argument("Radius must be non-negative");
+	}
+}
+
+
+void PredicateReporter::run(
+		const SpatialIndex& index,
+		std::ostream& logStream
+	)
+{
+	auto queries = getQuerySet();
+	ProgressLogger progress(logStream, queries.getSize());
+	unsigned id = 1;
+
+	for (auto query : queries) {
+		std::unique_ptr<Query> predicate = createQuery(id++, query);
+		unsigned long min = std::numeric_limits<unsigned long>::max();
+
+		for (unsigned run = 0; run < RUNS; ++run) {
+			clearCache();
+			Results results;
+			results.reserve(MIN_RESULT_SIZE);
+
+			// Time task
+			auto startTime = clock::now();
+			index.search(results, *predicate);
+			auto endTime = clock::now();
+
+			min = std::min<unsigned long>(
+					min,
+					std::chrono::duration_cast<std::chrono::microseconds>(
+							endTime - startTime
+						).count()
+				);
+		}
+
+		addEntry("query_runtime", min);
+
+		// Count visited nodes in a separate, instrumented search
+		StatsCollector stats;
+		index.search(stats, *predicate);
+
+		for (auto stat : stats) {
+			addEntry(stat.first, stat.second);
+		}
+
+		progress.increment();
+	}
+}
+
+
+std::unique_ptr<Query> PredicateReporter::createQuery(
+		unsigned id,
+		const RangeQuery& query
+	) const
+{
+	const Box& box = query.getBox();
+
+	switch (type) {
+		case Query::Type::CONTAINS:
+			return std::unique_ptr<Query>(new ContainsQuery(id, box));
+
+		case Query::Type::WITHIN:
+			return std::unique_ptr<Query>(new WithinQuery(id, box));
+
+		case Query::Type::RADIUS:
+			return std::unique_ptr<Query>(new RadiusQuery(id, box, radius));
+
+		default:
+			break;
+	}
+
+	const auto& points = box.getPoints();
+	Point center (points.first.getDimension());
+
+	for (unsigned d = 0; d < center.getDimension(); ++d) {
+		center[d] = (points.first[d] + points.second[d]) / 2.0;
+	}
+
+	return std::unique_ptr<Query>(new StabbingQuery(id, center));
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "RunTimeReporter.hpp"
+#include "QueryReporter.hpp"
+#include "spatial/Query.hpp"
+#include "spatial/RangeQuery.hpp"
+#include <memory>
+
+namespace Bench
+{
+
+/**
+ * Reports the run time and node accesses of containment, stabbing and
+ * radius queries.
+ *
+ * Query sets only hold boxes, thus each box is searched for the objects
+ * containing it, within it or within a radius of it, and stabbing queries
+ * use its center.
+ */
+class PredicateReporter : public QueryReporter, private RunTimeReporter
+{
+	public:
+
+		/**
+		 * @param queryPath Path to query set
+		 * @param type Type of the queries (CONTAINS, WITHIN, STAB or RADIUS)
+		 * @param radius Radius of radius queries
+		 */
+		PredicateReporter(
+				const std::string& queryPath,
+				Query::Type type,
+				double radius = 0.0
+			);
+
+		void run(
+				const SpatialIndex& index,
+				std::ostream& logStream
+			) override;
+
+	protected:
+		/**
+		 * Number of runs to take the minimum run time of.
+		 */
+		static const unsigned RUNS = 5;
+
+	private:
+		Query::Type type;
+		double radius;
+
+
+		/**
+		 * Create the query of this reporter's type from a query of the set.
+		 *
+		 * @param id Id of the query
+		 * @param query Range query read from the set
+		 * @return Query to search for
+		 */
+		std::unique_ptr<Query> createQuery(
+				unsigned id,
+				const RangeQuery& query
+			) const;
+};
+
+}
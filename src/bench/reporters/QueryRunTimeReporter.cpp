@@ -6,6 +6,20 @@
 namespace Bench
 {
 
+void QueryRunTimeReporter::setBuildStats(
+		std::chrono::microseconds duration,
+		unsigned long long objects,
+		unsigned threads
+	)
+{
+	addEntry("build_runtime", duration.count());
+	addEntry("build_threads", threads);
+	addEntry(
+			"build_throughput",
+			objects * 1e6 / std::max<long long>(duration.count(), 1)
+		);
+}
+
 void QueryRunTimeReporter::run(
 		const SpatialIndex& index,
 		std::ostream& logStream
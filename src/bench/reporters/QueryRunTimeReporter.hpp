@@ -19,6 +19,15 @@ class QueryRunTimeReporter : public QueryReporter, private RunTimeReporter
 				std::ostream& logStream
 			) override;
 
+		/**
+		 * Adds the build time and throughput (objects/s) to the report.
+		 */
+		void setBuildStats(
+				std::chrono::microseconds duration,
+				unsigned long long objects,
+				unsigned threads
+			) override;
+
 	protected:
 		/**
 		 * The run time will be measured within these constraints (in order of
@@ -3,6 +3,15 @@
 namespace Bench
 {
 
+void Reporter::setBuildStats(
+		std::chrono::microseconds,
+		unsigned long long,
+		unsigned
+	)
+{
+}
+
+
 std::ostream& operator<<(
 		std::ostream& stream, const std::shared_ptr<Reporter>& reporter
 	)
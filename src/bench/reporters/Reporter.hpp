@@ -1,5 +1,7 @@
 #pragma once
 #include "spatial/SpatialIndex.hpp"
+#include <chrono>
+#include <memory>
 #include <ostream>
 
 using namespace Spatial;
@@ -29,6 +31,22 @@ class Reporter
 		 * Output this report to the given stream.
 		 */
 		virtual void generate(std::ostream& stream) const = 0;
+
+		/**
+		 * Inform this reporter about how the index was built.
+		 *
+		 * This is called before `run`. It is ignored by default, but reporters
+		 * measuring run time may include it in their report.
+		 *
+		 * @param duration Time spent inserting or bulk loading the data set
+		 * @param objects Number of objects in the data set
+		 * @param threads Number of threads available to the index
+		 */
+		virtual void setBuildStats(
+				std::chrono::microseconds duration,
+				unsigned long long objects,
+				unsigned threads
+			);
 };
 
 std::ostream& operator<<(
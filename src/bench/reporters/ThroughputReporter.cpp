@@ -0,0 +1,201 @@
+#include "ThroughputReporter.hpp"
+#include "ProgressLogger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <thread>
+
+namespace Bench
+{
+
+/**
+ * Find the CPUs this process may run on.
+ *
+ * @return Ids of available CPUs
+ */
+std::vector<int> availableCpus()
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+
+	if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+		throw std::runtime_error("Could not get CPU affinity");
+	}
+
+	std::vector<int> cpus;
+
+	for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+		if (CPU_ISSET(cpu, &set)) {
+			cpus.push_back(cpu);
+		}
+	}
+
+	return cpus;
+}
+
+
+const unsigned long ThroughputReporter::DURATION;
+
+
+ThroughputReporter::ThroughputReporter(
+		const std::string& queryPath,
+		const std::vector<unsigned>& threads
+	) : QueryReporter(queryPath), threads(threads)
+{
+	if (std::find(threads.begin(), threads.end(), 0) != threads.end()) {
+		throw std::invalid_argument("Thread counts must be positive");
+	}
+}
+
+
+void ThroughputReporter::run(
+		const SpatialIndex& index,
+		std::ostream& logStream
+	)
+{
+	std::vector<int> cpus = availableCpus();
+
+	if (threads.empty()) {
+		for (unsigned n = 1; n <= cpus.size(); ++n) {
+			threads.push_back(n);
+		}
+	}
+
+	// Load queries into memory
+	auto querySet = getQuerySet();
+	std::vector<RangeQuery> queries (querySet.getSize());
+	std::transform(
+			querySet.begin(), querySet.end(),
+			queries.begin(),
+			[](const decltype(querySet)::value_type& query) {
+				return query;
+			}
+		);
+
+	if (queries.empty()) {
+		throw std::runtime_error("Throughput reporter needs queries");
+	}
+
+	ProgressLogger progress (logStream, threads.size());
+	double baseline = 0.0;
+
+	for (unsigned nThreads : threads) {
+		clearCache();
+
+		auto result = measure(index, queries, nThreads, cpus);
+		const auto& counts = result.first;
+
+		double total = 0.0;
+		double squares = 0.0;
+
+		for (unsigned long long count : counts) {
+			total += count;
+			squares += double(count) * count;
+		}
+
+		double throughput = total * 1e6 / result.second;
+
+		if (baseline == 0.0) {
+			baseline = throughput;
+		}
+
+		addEntry("threads", nThreads);
+		addEntry("throughput", throughput);
+		addEntry("speedup", throughput / baseline);
+		addEntry(
+				"fairness",
+				squares > 0.0 ? total * total / (nThreads * squares) : 1.0
+			);
+		addEntry(
+				"min_thread_throughput",
+				*std::min_element(counts.begin(), counts.end())
+					* 1e6 / result.second
+			);
+		addEntry(
+				"max_thread_throughput",
+				*std::max_element(counts.begin(), counts.end())
+					* 1e6 / result.second
+			);
+
+		increment();
+		progress.increment();
+	}
+}
+
+
+std::pair<std::vector<unsigned long long>, unsigned long long>
+ThroughputReporter::measure(
+		const SpatialIndex& index,
+		const std::vector<RangeQuery>& queries,
+		unsigned nThreads,
+		const std::vector<int>& cpus
+	) const
+{
+	std::atomic<bool> start (false);
+	std::atomic<bool> stop (false);
+	std::atomic<unsigned long long> next (0);
+	std::vector<unsigned long long> counts (nThreads, 0);
+	std::vector<std::thread> workers;
+
+	for (unsigned i = 0; i < nThreads; ++i) {
+		workers.emplace_back([&, i]() {
+			unsigned long long count = 0;
+
+			while (!start.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+
+			while (!stop.load(std::memory_order_relaxed)) {
+				unsigned long long q = next.fetch_add(
+						1, std::memory_order_relaxed
+					);
+
+				// Results are only counted, thus never materialized
+				CountingSink sink;
+				index.search(sink, queries[q % queries.size()]);
+				++count;
+			}
+
+			counts[i] = count;
+		});
+
+		// Pin worker to a CPU
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpus[i % cpus.size()], &set);
+
+		if (pthread_setaffinity_np(
+				workers.back().native_handle(), sizeof(set), &set
+			) != 0) {
+			stop = true;
+			start = true;
+
+			for (std::thread& worker : workers) {
+				worker.join();
+			}
+
+			throw std::runtime_error("Could not pin worker thread");
+		}
+	}
+
+	auto startTime = clock::now();
+	start.store(true, std::memory_order_release);
+
+	std::this_thread::sleep_for(period(DURATION));
+	stop = true;
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	auto endTime = clock::now();
+
+	return std::make_pair(
+			counts,
+			std::chrono::duration_cast<period>(endTime - startTime).count()
+		);
+}
+
+}
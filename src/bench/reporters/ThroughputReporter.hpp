@@ -0,0 +1,69 @@
+#pragma once
+#include "RunTimeReporter.hpp"
+#include "QueryReporter.hpp"
+#include <vector>
+
+namespace Bench
+{
+
+/**
+ * Measures the query throughput of an index with several threads.
+ *
+ * For each thread count, worker threads pinned to separate CPUs pull queries
+ * from a shared queue (cycling through the query set) for a fixed duration.
+ * The report contains the throughput in queries per second, the speedup
+ * relative to the first thread count and the fairness between the threads
+ * (Jain's fairness index, 1 when all threads ran the same number of queries).
+ */
+class ThroughputReporter : public QueryReporter, private RunTimeReporter
+{
+	public:
+
+		/**
+		 * Create a throughput reporter.
+		 *
+		 * @param queryPath Path to query set
+		 * @param threads Thread counts to measure (default is 1 to the number
+		 *        of available CPUs)
+		 */
+		ThroughputReporter(
+				const std::string& queryPath,
+				const std::vector<unsigned>& threads = {}
+			);
+
+		void run(
+				const SpatialIndex& index,
+				std::ostream& logStream
+			) override;
+
+	protected:
+
+		/**
+		 * Time to run queries for each thread count.
+		 */
+		static const unsigned long DURATION = 2000000; // µs
+
+	private:
+
+		std::vector<unsigned> threads;
+
+
+		/**
+		 * Run the queries with the given number of threads.
+		 *
+		 * @param index Index to query
+		 * @param queries Queries to run
+		 * @param nThreads Number of worker threads
+		 * @param cpus CPUs to pin the worker threads to (round robin)
+		 * @return Number of queries completed by each thread and the time
+		 *         spent in microseconds
+		 */
+		std::pair<std::vector<unsigned long long>, unsigned long long> measure(
+				const SpatialIndex& index,
+				const std::vector<RangeQuery>& queries,
+				unsigned nThreads,
+				const std::vector<int>& cpus
+			) const;
+};
+
+}
@@ -23,6 +23,15 @@ class TotalRunTimeReporter : public QueryReporter, private RunTimeReporter
 				std::ostream& logStream
 			) override;
 
+		/**
+		 * Adds the build time and throughput (objects/s) to the report.
+		 */
+		void setBuildStats(
+				std::chrono::microseconds duration,
+				unsigned long long objects,
+				unsigned threads
+			) override;
+
 	private:
 		unsigned runs;
 
@@ -6,7 +6,11 @@ using namespace Rtree;
 
 SpatialIndex * create(const Box&, unsigned long long)
 {
-	return new GreeneRtree<Node<>, m>();
+	auto index = new Traversed<GreeneRtree<Node<>, m>>();
+	index->setFillFactor(F);
+	index->setPages(PAGES);
+	index->setPrefetch(PREFETCH, PREFETCH_LINES);
+	return index;
 }
 
 void destroy(SpatialIndex * index)
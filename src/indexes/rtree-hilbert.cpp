@@ -7,10 +7,15 @@ using namespace Rtree;
 
 SpatialIndex * create(const Box& bounds, unsigned long long)
 {
-	return new HilbertRtree<
+	auto index = new Traversed<HilbertRtree<
 			Node<HilbertEntryPlugin>,
 			s
-		>(bounds);
+		>>(bounds);
+
+	index->setFillFactor(F);
+	index->setPages(PAGES);
+	index->setPrefetch(PREFETCH, PREFETCH_LINES);
+	return index;
 }
 
 void destroy(SpatialIndex * index)
@@ -7,10 +7,15 @@ using namespace Rtree;
 
 SpatialIndex * create(const Box&, unsigned long long)
 {
-	return new RRStarTree<
+	auto index = new Traversed<RRStarTree<
 			Node<CapturingEntryPlugin>,
 			m
-		>();
+		>>();
+
+	index->setFillFactor(F);
+	index->setPages(PAGES);
+	index->setPrefetch(PREFETCH, PREFETCH_LINES);
+	return index;
 }
 
 void destroy(SpatialIndex * index)
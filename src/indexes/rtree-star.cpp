@@ -6,11 +6,18 @@ using namespace Rtree;
 
 SpatialIndex * create(const Box&, unsigned long long)
 {
+	::Rtree::Rtree<Node<>, m> * index;
+
 	if (p != 0) {
-		return new RStarTree<Node<>, m, p>();
+		index = new Traversed<RStarTree<Node<>, m, p>>();
 	} else {
-		return new RStarTree<Node<>, m, M/3>();
+		index = new Traversed<RStarTree<Node<>, m, M/3>>();
 	}
+
+	index->setFillFactor(F);
+	index->setPages(PAGES);
+	index->setPrefetch(PREFETCH, PREFETCH_LINES);
+	return index;
 }
 
 void destroy(SpatialIndex * index)
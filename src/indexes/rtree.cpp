@@ -4,7 +4,11 @@
 
 SpatialIndex * create(const Box&, unsigned long long)
 {
-	return new Rtree::QuadraticRtree<Node<>, m>();
+	auto index = new Traversed<Rtree::QuadraticRtree<Node<>, m>>();
+	index->setFillFactor(F);
+	index->setPages(PAGES);
+	index->setPrefetch(PREFETCH, PREFETCH_LINES);
+	return index;
 }
 
 void destroy(SpatialIndex * index)
@@ -0,0 +1,159 @@
+#pragma once
+#include "EntryPlugin.hpp"
+#include <type_traits>
+#include <utility>
+
+namespace Rtree
+{
+
+/**
+ * Entry plugin keeping aggregates of the data objects in its subtree.
+ *
+ * Every entry knows the number of data objects below it, such that counting
+ * the objects in a region may stop at entries fully inside the region (see
+ * `Rtree::count`). A sum of a payload is kept as well if a payload is given
+ * (see below).
+ *
+ * The aggregates are updated whenever an entry is included or recalculated,
+ * thus insertion must include a new entry exactly once in each entry on its
+ * path.
+ *
+ * @tparam W Payload functor, giving the (numeric) payload of a data object,
+ *           or void to only count
+ */
+template<class W = void>
+class AggregateEntryPlugin;
+
+
+/**
+ * Aggregate entry plugin only counting data objects.
+ */
+template<>
+class AggregateEntryPlugin<void> : public EntryPlugin
+{
+	public:
+
+		AggregateEntryPlugin() = default;
+
+		// Copying a non-const plugin would otherwise construct from a host
+		AggregateEntryPlugin(const AggregateEntryPlugin&) = default;
+		AggregateEntryPlugin(AggregateEntryPlugin&) = default;
+		AggregateEntryPlugin& operator=(const AggregateEntryPlugin&) = default;
+
+
+		/**
+		 * Construct the plugin of a node entry, with no objects before
+		 * including its children.
+		 */
+		template<class E>
+		AggregateEntryPlugin(E& host)
+			: EntryPlugin(host), count(0)
+		{
+		}
+
+
+		/**
+		 * Construct the plugin of a data entry, counting its object.
+		 */
+		template<class E>
+		AggregateEntryPlugin(E& host, const DataObject& object)
+			: EntryPlugin(host, object), count(1)
+		{
+		}
+
+
+		template<class E, class BE>
+		void include(E& host, const BE& entry)
+		{
+			count += entry.getPlugin().getCount();
+		}
+
+
+		/**
+		 * @return Number of data objects in the subtree of the host entry
+		 */
+		unsigned long long getCount() const
+		{
+			return count;
+		}
+
+	private:
+		// Not initialized by default, as nodes may add their entries
+		// before constructing the entry storage
+		unsigned long long count;
+};
+
+
+/**
+ * Aggregate entry plugin summing a payload as well.
+ */
+template<class W>
+class AggregateEntryPlugin : public AggregateEntryPlugin<void>
+{
+	public:
+
+		/** Type of the payload and sums */
+		using Value = decltype(std::declval<const W&>()(
+				std::declval<const DataObject&>()
+			));
+
+		AggregateEntryPlugin() = default;
+
+		// Copying a non-const plugin would otherwise construct from a host
+		AggregateEntryPlugin(const AggregateEntryPlugin&) = default;
+		AggregateEntryPlugin(AggregateEntryPlugin&) = default;
+		AggregateEntryPlugin& operator=(const AggregateEntryPlugin&) = default;
+
+
+		template<class E>
+		AggregateEntryPlugin(E& host)
+			: AggregateEntryPlugin<void>(host), sum()
+		{
+		}
+
+
+		template<class E>
+		AggregateEntryPlugin(E& host, const DataObject& object)
+			: AggregateEntryPlugin<void>(host, object), sum(W()(object))
+		{
+		}
+
+
+		template<class E, class BE>
+		void include(E& host, const BE& entry)
+		{
+			AggregateEntryPlugin<void>::include(host, entry);
+			sum += entry.getPlugin().getSum();
+		}
+
+
+		/**
+		 * @return Sum of the payload of all data objects in the subtree
+		 */
+		Value getSum() const
+		{
+			return sum;
+		}
+
+	private:
+		Value sum;
+};
+
+
+/**
+ * Check whether an entry plugin keeps subtree counts.
+ *
+ * @tparam P Plugin type
+ */
+template<class P, class = void>
+struct IsAggregate : std::false_type
+{
+};
+
+template<class P>
+struct IsAggregate<P, decltype(void(std::declval<const P&>().getCount()))>
+	: std::true_type
+{
+};
+
+}
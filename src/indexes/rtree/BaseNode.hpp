@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <initializer_list>
 #include "Link.hpp"
 #include "Mbr.hpp"
@@ -34,6 +36,16 @@ namespace Rtree
 			static constexpr unsigned capacity = C;
 
 
+			/**
+			 * Whether the MBRs of the entries are kept as they are set.
+			 *
+			 * Nodes rounding MBRs relative to the node itself cannot keep the
+			 * MBR of their parent entry equal to the union of their entries,
+			 * only covering it.
+			 */
+			static constexpr bool tight = true;
+
+
 			/**
 			 * Construct an empty node.
 			 */
@@ -120,6 +132,95 @@ namespace Rtree
 			}
 
 
+			/**
+			 * Remove the entry at the given position.
+			 *
+			 * The following entries are moved one step forward, such that the
+			 * order of the remaining entries is kept.
+			 *
+			 * @param position Iterator to the entry to remove
+			 */
+			void erase(iterator position)
+			{
+				assert(position < end());
+				std::copy(position + 1, end(), position);
+				--size;
+			}
+
+
+			/**
+			 * Test a batch of queries against every entry in this node.
+			 *
+			 * By default, the node is scanned once for each query. Nodes able
+			 * to test several queries at once should hide this.
+			 *
+			 * @param queries MBRs of the queries (at most 64)
+			 * @param active Bit mask of the queries to test
+			 * @param masks Destination for the mask of queries intersecting
+			 *              each entry
+			 * @param parent Entry pointing to this node
+			 */
+			template<class M, class E>
+			void scanBatch(
+					const M * queries,
+					std::uint64_t active,
+					std::uint64_t * masks,
+					const E& parent
+				) const
+			{
+				auto node = static_cast<const Node *>(this);
+				std::fill(masks, masks + size, std::uint64_t(0));
+
+				for (std::uint64_t rest = active; rest; rest &= rest - 1) {
+					unsigned q = __builtin_ctzll(rest);
+					auto range = node->scan(queries[q], parent);
+
+					for (auto it = range.first; it != range.second; ++it) {
+						masks[it->index] |= std::uint64_t(1) << q;
+					}
+				}
+			}
+
+
+			/**
+			 * Calculate the squared distance from an MBR to every entry in
+			 * this node.
+			 *
+			 * By default, the MBR of each entry is fetched and measured.
+			 * Nodes able to measure several entries at once should hide this.
+			 *
+			 * @param mbr MBR to measure from
+			 * @param distances Destination for the distance to each entry
+			 */
+			template<class M>
+			void scanDistance(const M& mbr, double * distances) const
+			{
+				auto node = static_cast<const Node *>(this);
+
+				for (unsigned i = 0; i < size; ++i) {
+					distances[i] = node->getMbr(i).distance2(mbr);
+				}
+			}
+
+
+			/**
+			 * Give the MBR of a data object as stored in a node of this type.
+			 *
+			 * Entries of data objects take this MBR, such that their MBR
+			 * stays the same when stored in a node. By default, MBRs are
+			 * stored as they are, while nodes storing them with less
+			 * precision should hide this.
+			 *
+			 * @param mbr MBR of the object
+			 * @return MBR as stored
+			 */
+			template<class M>
+			static M stored(const M& mbr)
+			{
+				return mbr;
+			}
+
+
 			/**
 			 * Assign from initializer list.
 			 */
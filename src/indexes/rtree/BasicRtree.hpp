@@ -32,6 +32,17 @@ class BasicRtree : public Rtree<N, m>
 		void insert(const DataObject& object) override;
 
 	protected:
+		using Base::createNode;
+
+
+		/**
+		 * Create a leaf entry with a default initialized plugin.
+		 *
+		 * @param object Data object to create entry for
+		 * @return New entry for object
+		 */
+		Entry<N> createEntry(const DataObject& object) const override;
+
 
 		/**
 		 * Select a child of parent to be the destination of entry.
@@ -112,7 +123,7 @@ Entry<N> BasicRtree<N, m>::split(
 	)
 {
 	// Create new entry (and node with included entry)
-	Entry<N> newEntry = Entry<N>(new N({include}));
+	Entry<N> newEntry = Entry<N>(createNode({include}));
 
 	// Redistribute children between nodes
 	redistribute(
@@ -128,6 +139,12 @@ Entry<N> BasicRtree<N, m>::split(
 	return newEntry;
 }
 
+template<class N, unsigned m>
+Entry<N> BasicRtree<N, m>::createEntry(const DataObject& object) const
+{
+	return Entry<N>(object);
+}
+
 template<class N, unsigned m>
 void BasicRtree<N, m>::insert(const DataObject& object)
 {
@@ -146,13 +163,13 @@ void BasicRtree<N, m>::insert(const DataObject& object)
 	Entry<N> entry = original;
 
 	if (getHeight() > 2) {
-		// Dig down to destination leaf node and update MBRs on the way
+		// Dig down to destination leaf node. The entries on the way are
+		// updated once the new entry has been added (or split into them).
 		std::vector<typename N::iterator> path {
 				chooseSubtree(getRoot(), entry)
 			};
 
 		while (path.size() < getHeight() - 2) {
-			path.back()->include(entry);
 			path.push_back(
 					chooseSubtree(*path.back(), entry)
 				);
@@ -196,7 +213,7 @@ template<class N, unsigned m>
 void BasicRtree<N, m>::splitRoot(const Entry<N>& entry)
 {
 	addLevel(
-			Entry<N>(new N({getRoot(), entry}))
+			Entry<N>(createNode({getRoot(), entry}))
 		);
 }
 
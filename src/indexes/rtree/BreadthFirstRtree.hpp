@@ -0,0 +1,34 @@
+#pragma once
+#include "Rtree.hpp"
+
+namespace Rtree
+{
+
+/**
+ * R-tree whose range and predicate searches scan a level at a time.
+ *
+ * The matching nodes of each level are kept in a frontier, visited in the
+ * order of their addresses (see `Rtree::levelSearch`). Large queries then
+ * stream through the nodes rather than chasing pointers, while small ones
+ * are better off with the depth-first search of the tree itself.
+ *
+ * @tparam T R-tree type to search breadth-first
+ */
+template<class T>
+class BreadthFirstRtree : public T
+{
+	public:
+		using T::T;
+
+
+		void predicateSearch(
+				ResultSink& sink,
+				const Box& box,
+				Predicate predicate
+			) const override
+		{
+			this->levelSearch(sink, box, predicate);
+		}
+};
+
+}
@@ -44,7 +44,7 @@ namespace Rtree
 					ScanIterator() = default;
 
 					/**
-					 * Construct a scan iterator yielding entries overlapping
+					 * Construct a scan iterator yielding entries matching an
 					 * MBR.
 					 *
 					 * Note that only a reference to the given MBR is store,
@@ -52,14 +52,16 @@ namespace Rtree
 					 * iterator.
 					 *
 					 * @param node Node to scan through
-					 * @param mbr MBR yielded entries must overlap
+					 * @param mbr MBR yielded entries must match
 					 * @param i Index to start at
+					 * @param predicate Relation between entries and MBR
 					 */
 					ScanIterator(
 							const DefaultNode * node,
 							const Mbr * mbr,
-							unsigned index
-						) : Base(node, index), mbr(mbr)
+							unsigned index,
+							Predicate predicate = Predicate::INTERSECTS
+						) : Base(node, index), mbr(mbr), predicate(predicate)
 					{
 						findNext();
 					};
@@ -97,12 +99,13 @@ namespace Rtree
 
 				private:
 					const Mbr * mbr;
+					Predicate predicate;
 
 					/**
-					 * Finds the first position intersecting with the MBR.
+					 * Finds the first position matching the MBR.
 					 *
-					 * This includes the current position if it intersects with
-					 * the MBR. `i` is updated to the found position.
+					 * This includes the current position if it matches the
+					 * MBR. `i` is updated to the found position.
 					 */
 					void findNext()
 					{
@@ -110,7 +113,7 @@ namespace Rtree
 						const DefaultNode * node = entry.node;
 						while (
 							index < node->getSize() &&
-							!node->entries[index].mbr.intersects(*mbr)
+							!node->entries[index].mbr.matches(*mbr, predicate)
 						) {
 							++index;
 						}
@@ -124,11 +127,12 @@ namespace Rtree
 			template<class E>
 			std::pair<ScanIterator, ScanIterator> scan(
 					const Mbr& mbr,
-					const E&
+					const E&,
+					Predicate predicate = Predicate::INTERSECTS
 				) const
 			{
 				return std::make_pair(
-						ScanIterator(this, &mbr, 0),
+						ScanIterator(this, &mbr, 0, predicate),
 						ScanIterator(this, nullptr, getSize())
 					);
 			}
@@ -143,7 +147,7 @@ namespace Rtree
 			 */
 			Plugin getPlugin(unsigned index) const
 			{
-				return entries[index].plugin;
+				return static_cast<const Plugin&>(entries[index]);
 			}
 
 
@@ -200,19 +204,21 @@ namespace Rtree
 			 */
 			void setPlugin(unsigned index, const Plugin& p)
 			{
-				entries[index].plugin = p;
+				static_cast<Plugin&>(entries[index]) = p;
 			}
 
 
 		private:
 			/**
 			 * Simple struct for storing MBR, link and plugin in the same place.
+			 *
+			 * The plugin is a base, such that plugins without state take no
+			 * room next to the MBR and link (empty base optimization).
 			 */
-			struct SimpleEntry
+			struct SimpleEntry : Plugin
 			{
 				Mbr mbr;
 				Link link;
-				Plugin plugin;
 			};
 
 			SimpleEntry entries[C];
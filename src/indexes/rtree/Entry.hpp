@@ -3,10 +3,42 @@
 #include "Mbr.hpp"
 #include "EntryPlugin.hpp"
 #include <algorithm>
+#include <utility>
 
 namespace Rtree
 {
 
+	/**
+	 * Give the MBR of a data object as stored in a node of type N.
+	 *
+	 * This is N::stored when the node defines it, or else the MBR itself.
+	 *
+	 * @tparam N Node type
+	 */
+	template<class N, class = void>
+	struct StoredMbr
+	{
+		template<class M>
+		static M get(const M& mbr)
+		{
+			return mbr;
+		}
+	};
+
+	template<class N>
+	struct StoredMbr<
+			N,
+			decltype(void(N::stored(std::declval<const typename N::Mbr&>())))
+		>
+	{
+		template<class M>
+		static M get(const M& mbr)
+		{
+			return N::stored(mbr);
+		}
+	};
+
+
 	/**
 	 * An entry in a node of the R-tree.
 	 *
@@ -244,7 +276,7 @@ namespace Rtree
 			 */
 			template<class ...Args>
 			Entry(const DataObject& object, Args ...args)
-				: mbr(object.getBox()), link(object.getId()),
+				: mbr(StoredMbr<N>::get(Mbr(object.getBox()))), link(object.getId()),
 					plugin(*this, object, std::forward<Args...>(args...))
 			{
 			};
@@ -258,7 +290,7 @@ namespace Rtree
 			 * @param object Object to grab MBR and id from
 			 */
 			Entry(const DataObject& object)
-				: mbr(object.getBox()), link(object.getId()),
+				: mbr(StoredMbr<N>::get(Mbr(object.getBox()))), link(object.getId()),
 					plugin(*this, object)
 			{
 			}
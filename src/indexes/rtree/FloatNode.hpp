@@ -0,0 +1,640 @@
+#pragma once
+#include "BaseNode.hpp"
+#include "PluginArray.hpp"
+#include "ProxyScanIterator.hpp"
+#include "spatial/Coordinate.hpp"
+#include "immintrin.h"
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace Rtree
+{
+
+	/**
+	 * Represents a vectorized node keeping the MBRs of its entries in single
+	 * precision.
+	 *
+	 * The layout is that of `VectorizedNode`, but with floats, such that a
+	 * block holds eight entries and each scan compares eight entries at a
+	 * time. Bottoms are rounded down and tops up, thus each stored MBR covers
+	 * the original one. Queries are rounded the same way before comparing,
+	 * and since rounding keeps the order of values, no entry matching a query
+	 * is ever missed (for any predicate). Entries just outside a query may
+	 * however match as well.
+	 *
+	 * With EXACT set, the original MBRs are kept besides the blocks, and each
+	 * entry matching the single precision scan is checked against its
+	 * original MBR. The blocks are then only a filter, and the results are
+	 * the same as with double precision. Use the `FloatNode` and
+	 * `ExactFloatNode` aliases to pick either.
+	 *
+	 * @tparam D Dimension
+	 * @tparam C Max capacity
+	 * @tparam P Plugin
+	 * @tparam EXACT Whether to check matches against the original MBRs
+	 */
+	template<unsigned D, unsigned C, class P, bool EXACT>
+	class BasicFloatNode
+		: public BaseNode<BasicFloatNode<D, C, P, EXACT>, C, P>
+	{
+		using Base = BaseNode<BasicFloatNode<D, C, P, EXACT>, C, P>;
+		using Coordinate = Spatial::Coordinate;
+
+		static constexpr unsigned BLOCK_SIZE = 8;
+		static constexpr unsigned N_BLOCKS = (C + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+
+		public:
+			using Mbr = ::Rtree::Mbr<D>;
+			using Link = ::Rtree::Link<BasicFloatNode>;
+			using Plugin = P;
+
+			// Inherit constructor and operator=
+			using Base::Base;
+			using Base::operator=;
+
+			// Depends on template parameters
+			using Base::getSize;
+
+
+			/**
+			 * An MBR rounded outwards to single precision.
+			 */
+			struct FloatMbr
+			{
+				float bottom[D];
+				float top[D];
+
+				FloatMbr() = default;
+
+				FloatMbr(const Mbr& mbr)
+				{
+					for (unsigned d = 0; d < D; ++d) {
+						bottom[d] = roundDown(mbr.getBottom()[d]);
+						top[d] = roundUp(mbr.getTop()[d]);
+					}
+				}
+			};
+
+
+			class ScanIterator : public ProxyScanIterator<BasicFloatNode>
+			{
+				using Base = ProxyScanIterator<BasicFloatNode>;
+				using Base::entry;
+
+				public:
+					ScanIterator() = default;
+
+					ScanIterator(
+							const BasicFloatNode * node,
+							const Mbr& mbr,
+							unsigned index,
+							Predicate predicate = Predicate::INTERSECTS
+						) : Base(node, index), mbr(&mbr), predicate(predicate)
+					{
+						if (index < node->getSize()) {
+							query = FloatMbr(mbr);
+							bitset = scanBlock();
+							findNext();
+						}
+					};
+
+					ScanIterator& operator++()
+					{
+						assert(entry.index < entry.node->getSize());
+
+						next();
+						findNext();
+
+						return *this;
+					}
+
+					ScanIterator operator++(int)
+					{
+						ScanIterator it = *this;
+						operator++();
+						return it;
+					}
+
+				private:
+					const Mbr * mbr;
+					FloatMbr query;
+					Predicate predicate;
+					unsigned bitset;
+
+
+					/**
+					 * Jump to the next position.
+					 *
+					 * This proceeds without any questions asked, and also keeps
+					 * the internal bitset up-to-date.
+					 */
+					void next()
+					{
+						unsigned& index = entry.index;
+
+						bitset >>= 1;
+						++index;
+
+						if (index % BLOCK_SIZE == 0) {
+							bitset = scanBlock();
+						}
+					}
+
+
+					/**
+					 * Scans until the next matching entry is found.
+					 *
+					 * Entries passing the single precision scan are checked
+					 * against their original MBRs if those are kept. Also
+					 * stops when the end of the node is reached.
+					 */
+					void findNext()
+					{
+						unsigned& index = entry.index;
+						const BasicFloatNode * node = entry.node;
+
+						while (index < node->getSize()) {
+							if (
+									(bitset & 1) && (
+										!EXACT ||
+										node->getMbr(index).matches(
+											*mbr, predicate
+										)
+									)
+							) {
+								break;
+							}
+
+							next();
+						}
+					}
+
+
+					/**
+					 * Scan the current block and update bitset.
+					 */
+					unsigned scanBlock() const
+					{
+						switch (predicate) {
+							case Predicate::CONTAINS:
+								return scanBlock<_CMP_LE_OS, _CMP_GE_OS>(
+										query.bottom, query.top
+									);
+
+							case Predicate::WITHIN:
+								return scanBlock<_CMP_GE_OS, _CMP_LE_OS>(
+										query.bottom, query.top
+									);
+
+							default:
+								return scanBlock<_CMP_LE_OS, _CMP_GE_OS>(
+										query.top, query.bottom
+									);
+						}
+					}
+
+
+					/**
+					 * Compare the bottoms and tops in the current block
+					 * against a reference value for each dimension.
+					 *
+					 * @tparam BOTTOM_OP Compare operation for the bottoms
+					 * @tparam TOP_OP Compare operation for the tops
+					 *
+					 * @param bottoms Reference values for the bottoms
+					 * @param tops Reference values for the tops
+					 * @return Bitset of entries passing all comparisons
+					 */
+					template<int BOTTOM_OP, int TOP_OP>
+					unsigned scanBlock(
+							const float * bottoms,
+							const float * tops
+						) const
+					{
+						const unsigned& index = entry.index;
+						const BasicFloatNode * node = entry.node;
+
+						unsigned block = index / BLOCK_SIZE;
+						unsigned bitset = (1 << BLOCK_SIZE) - 1;
+						const float * base = reinterpret_cast<const float*>(
+								node->coordinates + 2 * D * block
+							);
+
+						// Compare across all dimensions
+						for (unsigned j = 0; j < D; ++j) {
+
+							// Load reference values
+							__m256 bottom = _mm256_broadcast_ss(&bottoms[j]);
+							__m256 top = _mm256_broadcast_ss(&tops[j]);
+
+							// Load bottom and top for subject
+							__m256 sbottom = _mm256_load_ps(base);
+							__m256 stop = _mm256_load_ps(base + BLOCK_SIZE);
+
+							bitset &= _mm256_movemask_ps(
+									_mm256_cmp_ps(sbottom, bottom, BOTTOM_OP)
+								) & _mm256_movemask_ps(
+									_mm256_cmp_ps(stop, top, TOP_OP)
+								);
+
+							base += 2 * BLOCK_SIZE;
+						}
+
+						return bitset;
+					}
+			};
+
+
+
+
+			/**
+			 * Scan node and return set of matching entries.
+			 */
+			template<class E>
+			std::pair<ScanIterator, ScanIterator> scan(
+					const Mbr& mbr,
+					const E&,
+					Predicate predicate = Predicate::INTERSECTS
+				) const
+			{
+				return std::make_pair(
+						ScanIterator(this, mbr, 0, predicate),
+						ScanIterator(this, mbr, getSize())
+					);
+			}
+
+
+			/**
+			 * Test a batch of queries against every entry in this node.
+			 *
+			 * Each block is loaded once and then compared against all the
+			 * queries, eight entries at a time.
+			 *
+			 * @see BaseNode::scanBatch
+			 */
+			template<class E>
+			void scanBatch(
+					const Mbr * queries,
+					std::uint64_t active,
+					std::uint64_t * masks,
+					const E&
+				) const
+			{
+				FloatMbr rounded[64];
+
+				for (std::uint64_t rest = active; rest; rest &= rest - 1) {
+					unsigned q = __builtin_ctzll(rest);
+					rounded[q] = FloatMbr(queries[q]);
+				}
+
+				for (unsigned block = 0; block < N_BLOCKS; ++block) {
+					const unsigned first = block * BLOCK_SIZE;
+
+					if (first >= getSize()) {
+						break;
+					}
+
+					const float * base = reinterpret_cast<const float*>(
+							coordinates + 2 * D * block
+						);
+
+					// Load bottom and top for subjects
+					__m256 sbottom[D], stop[D];
+
+					for (unsigned j = 0; j < D; ++j) {
+						sbottom[j] = _mm256_load_ps(base + 2 * BLOCK_SIZE * j);
+						stop[j] = _mm256_load_ps(
+								base + 2 * BLOCK_SIZE * j + BLOCK_SIZE
+							);
+					}
+
+					std::uint64_t lanes[BLOCK_SIZE] = {};
+
+					for (std::uint64_t rest = active; rest; rest &= rest - 1) {
+						unsigned q = __builtin_ctzll(rest);
+						unsigned bitset = (1 << BLOCK_SIZE) - 1;
+
+						// Compare across all dimensions
+						for (unsigned j = 0; j < D; ++j) {
+							__m256 bottom = _mm256_broadcast_ss(
+									&rounded[q].bottom[j]
+								);
+							__m256 top = _mm256_broadcast_ss(&rounded[q].top[j]);
+
+							bitset &= _mm256_movemask_ps(
+									_mm256_cmp_ps(top, sbottom[j], _CMP_GE_OS)
+								) & _mm256_movemask_ps(
+									_mm256_cmp_ps(stop[j], bottom, _CMP_GE_OS)
+								);
+						}
+
+						for (; bitset; bitset &= bitset - 1) {
+							const unsigned i = __builtin_ctz(bitset);
+
+							if (
+									!EXACT ||
+									exact[first + i].intersects(queries[q])
+							) {
+								lanes[i] |= std::uint64_t(1) << q;
+							}
+						}
+					}
+
+					const unsigned n = std::min(
+							getSize() - first,
+							unsigned(BLOCK_SIZE)
+						);
+					std::copy(lanes, lanes + n, masks + first);
+				}
+			}
+
+
+			/**
+			 * Calculate the squared distance from an MBR to every entry in
+			 * this node.
+			 *
+			 * The gaps are found from the single precision blocks, four
+			 * entries at a time in double precision, and thus never exceed
+			 * the distance to the original MBRs. With EXACT set, the
+			 * distance to the original MBRs is calculated instead.
+			 *
+			 * @see BaseNode::scanDistance
+			 */
+			void scanDistance(const Mbr& mbr, double * distances) const
+			{
+				if (EXACT) {
+					Base::scanDistance(mbr, distances);
+					return;
+				}
+
+				auto highs = mbr.getTop();
+				auto lows = mbr.getBottom();
+				const __m256d zero = _mm256_setzero_pd();
+
+				for (unsigned block = 0; block < N_BLOCKS; ++block) {
+					const unsigned first = block * BLOCK_SIZE;
+
+					if (first >= getSize()) {
+						break;
+					}
+
+					const float * base = reinterpret_cast<const float*>(
+							coordinates + 2 * D * block
+						);
+
+					// Each half of the block, four entries each
+					__m256d sum[2] = {zero, zero};
+
+					for (unsigned j = 0; j < D; ++j) {
+						const __m256d high = _mm256_broadcast_sd(&highs[j]);
+						const __m256d low = _mm256_broadcast_sd(&lows[j]);
+
+						for (unsigned h = 0; h < 2; ++h) {
+							__m256d sbottom = _mm256_cvtps_pd(
+									_mm_load_ps(base + 4 * h)
+								);
+							__m256d stop = _mm256_cvtps_pd(
+									_mm_load_ps(base + BLOCK_SIZE + 4 * h)
+								);
+
+							// Gap below or above the MBR, whichever is positive
+							__m256d gap = _mm256_max_pd(
+									_mm256_max_pd(
+										zero,
+										_mm256_sub_pd(sbottom, high)
+									),
+									_mm256_sub_pd(low, stop)
+								);
+
+							sum[h] = _mm256_add_pd(
+									sum[h],
+									_mm256_mul_pd(gap, gap)
+								);
+						}
+
+						base += 2 * BLOCK_SIZE;
+					}
+
+					double lanes[BLOCK_SIZE];
+					_mm256_storeu_pd(lanes, sum[0]);
+					_mm256_storeu_pd(lanes + 4, sum[1]);
+
+					const unsigned n = std::min(
+							getSize() - first,
+							unsigned(BLOCK_SIZE)
+						);
+					std::copy(lanes, lanes + n, distances + first);
+				}
+			}
+
+
+			/**
+			 * Override new operator to make sure memory is aligned.
+			 */
+			void * operator new(std::size_t count)
+			{
+				void * p;
+				int error = posix_memalign(&p, sizeof(__m256), count);
+
+				// Convert C-style error to exception
+				if (error) {
+					throw std::bad_alloc();
+				}
+
+				return p;
+			}
+
+
+			/**
+			 * Override delete operator to use correct delete method.
+			 */
+			void operator delete (void * pointer)
+			{
+				free(pointer);
+			}
+
+
+
+			/**
+			 * Get the plugin of an entry in this node.
+			 *
+			 * @param index Index of entry
+			 * @return Plugin of entry at the given index
+			 */
+			Plugin getPlugin(unsigned index) const
+			{
+				return plugins[index];
+			}
+
+
+			/**
+			 * Get the link of an entry in this node.
+			 *
+			 * @param index Index of entry
+			 * @return Link of entry at the given index
+			 */
+			Link getLink(unsigned index) const
+			{
+				return links[index];
+			}
+
+
+			/**
+			 * Get the MBR of an entry in this node.
+			 *
+			 * Without EXACT, this is the rounded MBR, which covers the
+			 * original one.
+			 *
+			 * @param index Index of entry
+			 * @return MBR of entry at the given index
+			 */
+			Mbr getMbr(unsigned index) const
+			{
+				if (EXACT) {
+					return exact[index];
+				}
+
+				std::array<Coordinate, D> bottom, top;
+
+				auto base = reinterpret_cast<const float *>(
+						coordinates + 2 * D * (index / BLOCK_SIZE)
+					) + index % BLOCK_SIZE;
+
+				for (unsigned d = 0; d < D; ++d) {
+					bottom[d] = base[0];
+					top[d] = base[BLOCK_SIZE];
+					base += 2 * BLOCK_SIZE;
+				}
+
+				return Mbr(top, bottom);
+			}
+
+
+			/**
+			 * Set the MBR of an entry in this node.
+			 *
+			 * @param index Index of entry for which to set MBR
+			 */
+			void setMbr(unsigned index, const Mbr& m)
+			{
+				const FloatMbr rounded (m);
+
+				auto base = reinterpret_cast<float *>(
+						coordinates + 2 * D * (index / BLOCK_SIZE)
+					) + index % BLOCK_SIZE;
+
+				for (unsigned d = 0; d < D; ++d) {
+					base[0] = rounded.bottom[d];
+					base[BLOCK_SIZE] = rounded.top[d];
+					base += 2 * BLOCK_SIZE;
+				}
+
+				if (EXACT) {
+					exact[index] = m;
+				}
+			}
+
+
+			/**
+			 * Set the link of an entry in this node.
+			 *
+			 * @param index Index of entry for which to set link
+			 */
+			void setLink(unsigned index, const Link& l)
+			{
+				links[index] = l;
+			}
+
+
+			/**
+			 * Set the plugin of an entry in this node.
+			 *
+			 * @param index Index of entry for which to set plugin
+			 */
+			void setPlugin(unsigned index, const Plugin& p)
+			{
+				plugins[index] = p;
+			}
+
+
+			/**
+			 * Give the MBR of a data object as stored in this node.
+			 *
+			 * Without EXACT, this is the rounded MBR.
+			 *
+			 * @see BaseNode::stored
+			 */
+			static Mbr stored(const Mbr& mbr)
+			{
+				if (EXACT) {
+					return mbr;
+				}
+
+				const FloatMbr rounded (mbr);
+				std::array<Coordinate, D> bottom, top;
+
+				std::copy(rounded.bottom, rounded.bottom + D, bottom.begin());
+				std::copy(rounded.top, rounded.top + D, top.begin());
+
+				return Mbr(top, bottom);
+			}
+
+
+			/**
+			 * Round a coordinate down to the closest float.
+			 */
+			static float roundDown(Coordinate value)
+			{
+				float rounded = static_cast<float>(value);
+
+				return rounded > value
+					? std::nextafter(
+						rounded,
+						-std::numeric_limits<float>::infinity()
+					)
+					: rounded;
+			}
+
+
+			/**
+			 * Round a coordinate up to the closest float.
+			 */
+			static float roundUp(Coordinate value)
+			{
+				float rounded = static_cast<float>(value);
+
+				return rounded < value
+					? std::nextafter(
+						rounded,
+						std::numeric_limits<float>::infinity()
+					)
+					: rounded;
+			}
+
+
+		private:
+			__m256 coordinates[N_BLOCKS * 2 * D];
+			Link links[C];
+			PluginArray<Plugin, C> plugins;
+
+			// Original MBRs, only used with EXACT
+			Mbr exact[EXACT ? C : 1];
+	};
+
+
+	/**
+	 * Single precision node, matching entries just outside queries too.
+	 */
+	template<unsigned D, unsigned C, class P = EntryPlugin>
+	using FloatNode = BasicFloatNode<D, C, P, false>;
+
+
+	/**
+	 * Single precision node, checking matches against the original MBRs.
+	 */
+	template<unsigned D, unsigned C, class P = EntryPlugin>
+	using ExactFloatNode = BasicFloatNode<D, C, P, true>;
+
+}
@@ -0,0 +1,112 @@
+#include "Node.test.hpp"
+#include "FloatNode.hpp"
+
+Test(FloatNode, data_retainment)
+{
+	testRetainment<FloatNode>();
+	testRetainment<ExactFloatNode>();
+}
+
+
+Test(FloatNode, scan)
+{
+	testScanning<FloatNode>();
+	testScanning<ExactFloatNode>();
+}
+
+
+Test(FloatNode, scan_batch)
+{
+	testBatchScanning<FloatNode>();
+	testBatchScanning<ExactFloatNode>();
+}
+
+
+Test(FloatNode, scan_predicates)
+{
+	testPredicateScanning<FloatNode>();
+	testPredicateScanning<ExactFloatNode>();
+}
+
+
+Test(FloatNode, scan_distance)
+{
+	testDistanceScanning<FloatNode>();
+	testDistanceScanning<ExactFloatNode>();
+}
+
+
+Test(FloatNode, rounding)
+{
+	using N = FloatNode<2, 8, EntryPlugin>;
+	using X = ExactFloatNode<2, 8, EntryPlugin>;
+
+	// Not representable as floats
+	Mbr<2> mbr = Box(Point {0.1, 1e-40}, Point {0.3, 0.7});
+
+	N node;
+	X exact;
+	node.add(Entry<N>(mbr, 1, EntryPlugin()));
+	exact.add(Entry<X>(mbr, 1, EntryPlugin()));
+
+	cr_expect(
+			node.getMbr(0).contains(mbr),
+			"Stored MBR should cover the original"
+		);
+	cr_expect_eq(
+			exact.getMbr(0),
+			mbr,
+			"Exact node should keep the original MBR"
+		);
+
+	// Touching the original from each side, and just missing it
+	const double gap = 1e-12;
+	std::vector<std::pair<Mbr<2>, bool>> queries {
+			{Box(Point {0.3, 0.0}, Point {0.4, 0.1}), true},
+			{Box(Point {0.0, 0.0}, Point {0.1, 0.1}), true},
+			{Box(Point {0.0, 0.0}, Point {0.2, 0.2}), true},
+			{Box(Point {0.3 + gap, 0.0}, Point {0.4, 0.1}), false},
+			{Box(Point {0.0, 0.0}, Point {0.1 - gap, 0.1}), false},
+		};
+
+	for (const auto& query : queries) {
+		auto range = node.scan(query.first, Entry<N>(&node));
+		auto exactRange = exact.scan(query.first, Entry<X>(&exact));
+
+		if (query.second) {
+			cr_expect(
+					range.first != range.second,
+					"Rounding should never lose a match"
+				);
+		}
+
+		cr_expect_eq(
+				exactRange.first != exactRange.second,
+				query.second,
+				"Exact node should match as with double precision"
+			);
+	}
+
+	// Within a box ending exactly at the original
+	auto within = node.scan(
+			Mbr<2>(Box(Point {0.1, 0.0}, Point {0.3, 0.7})),
+			Entry<N>(&node),
+			Predicate::WITHIN
+		);
+
+	cr_expect(
+			within.first != within.second,
+			"Rounding should never lose a match within a query"
+		);
+
+	// Distances never exceed those to the original
+	double distance;
+	Mbr<2> point (Point {0.5, 0.5});
+	node.scanDistance(point, &distance);
+
+	cr_expect_leq(
+			distance,
+			mbr.distance2(point),
+			"Distance should not exceed the one to the original"
+		);
+}
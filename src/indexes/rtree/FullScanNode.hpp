@@ -1,27 +1,12 @@
 #pragma once
 #include "BaseNode.hpp"
+#include "PluginArray.hpp"
 #include "ProxyScanIterator.hpp"
 #include "spatial/Coordinate.hpp"
+#include "spatial/Lanes.hpp"
 #include "immintrin.h"
 #include <iostream>
 
-/**
- * Scans forward through a number and finds the first set bit.
- *
- * Note that the behavior is undefined should no bits be set (value = 0).
- *
- * @tparam I Integer type of the number. Must be 16, 32 or 64 bit.
- * @param value Number to scan through
- * @return Index of first set bit
- */
-template<class I>
-I bitScanForward(const I& value)
-{
-	I r;
-	asm("bsfl %1,%0" : "=r" (r) : "rm" (value));
-	return r;
-}
-
 
 namespace Rtree
 {
@@ -30,14 +15,19 @@ namespace Rtree
 	 * Represents a vectorized node where an arrays of subfields approach has
 	 * been combined with vectorized scans (and full node scans).
 	 *
+	 * Use the `FullScanNode` (AVX2, or picked at runtime when the build does
+	 * not target it) and `FullScanNode512` (AVX-512) aliases to pick the vectors.
+	 *
 	 * @tparam D Dimension
 	 * @tparam C Max capacity
 	 * @tparam P Plugin
+	 * @tparam L Vector kernels (e.g. Spatial::Avx2Lanes)
 	 */
-	template<unsigned D, unsigned C, class P = EntryPlugin>
-	class FullScanNode : public BaseNode<FullScanNode<D, C, P>, C, P>
+	template<unsigned D, unsigned C, class P, class L>
+	class BasicFullScanNode
+		: public BaseNode<BasicFullScanNode<D, C, P, L>, C, P>
 	{
-		using Base = BaseNode<FullScanNode<D, C, P>, C, P>;
+		using Base = BaseNode<BasicFullScanNode<D, C, P, L>, C, P>;
 		using Coordinate = Spatial::Coordinate;
 
 
@@ -46,13 +36,13 @@ namespace Rtree
 				"Vector node assumes doubles"
 			);
 
-		static constexpr unsigned BLOCK_SIZE = 4;
+		static constexpr unsigned BLOCK_SIZE = L::WIDTH;
 		static constexpr unsigned N_BLOCKS = (C + BLOCK_SIZE - 1) / BLOCK_SIZE;
 
 
 		public:
 			using Mbr = ::Rtree::Mbr<D>;
-			using Link = ::Rtree::Link<FullScanNode>;
+			using Link = ::Rtree::Link<BasicFullScanNode>;
 			using Plugin = P;
 
 			// Inherit constructor and operator=
@@ -63,11 +53,11 @@ namespace Rtree
 			using Base::getSize;
 
 
-			class ScanIterator : public ProxyScanIterator<FullScanNode>
+			class ScanIterator : public ProxyScanIterator<BasicFullScanNode>
 			{
 				// Bit set block type
 				using BS = unsigned;
-				using Base = ProxyScanIterator<FullScanNode>;
+				using Base = ProxyScanIterator<BasicFullScanNode>;
 				using Base::entry;
 
 				// Number of bits in each bit set block
@@ -81,9 +71,10 @@ namespace Rtree
 					 * index.
 					 */
 					ScanIterator(
-							const FullScanNode * node,
+							const BasicFullScanNode * node,
 							const Mbr& mbr,
-							unsigned index
+							unsigned index,
+							Predicate predicate = Predicate::INTERSECTS
 						) : Base(node, index)
 					{
 						if (index >= node->getSize()) {
@@ -98,38 +89,51 @@ namespace Rtree
 							bitset[i] = ~0;
 						}
 
-						const double * base = reinterpret_cast<const double *>(
-								node->coordinates
-							);
+						const double * base = node->coordinates;
 
 						auto highs = mbr.getTop();
 						auto lows = mbr.getBottom();
 						unsigned blocks = (node->getSize() + BLOCK_SIZE - 1) / BLOCK_SIZE;
 
-						// Compare across all dimensions
-						for (unsigned d = 0; d < D; ++d) {
-							// Check top of query
-							scanStrip<_CMP_LE_OS>(
-									base + 2 * d * BLOCK_SIZE * N_BLOCKS,
-									&highs[d],
-									blocks
-								);
+						switch (predicate) {
+							case Predicate::CONTAINS:
+								scanStrips<_CMP_LE_OS, _CMP_GE_OS>(
+										base, lows, highs, blocks
+									);
+								break;
 
-							// Check bottom of query
-							scanStrip<_CMP_GE_OS>(
-									base + (2 * d + 1) * BLOCK_SIZE * N_BLOCKS,
-									&lows[d],
-									blocks
-								);
+							case Predicate::WITHIN:
+								scanStrips<_CMP_GE_OS, _CMP_LE_OS>(
+										base, lows, highs, blocks
+									);
+								break;
+
+							default:
+								// Check top and bottom of query
+								scanStrips<_CMP_LE_OS, _CMP_GE_OS>(
+										base, highs, lows, blocks
+									);
 						}
 
+						current = 0;
+						next = 0;
+						found = L::compress(bitset[0], positions);
+
 						findNext();
 					};
 
 					ScanIterator& operator=(const ScanIterator& other)
 					{
-						ProxyScanIterator<FullScanNode>::operator=(other);
+						ProxyScanIterator<BasicFullScanNode>::operator=(other);
 						bitset = other.bitset;
+						current = other.current;
+						next = other.next;
+						found = other.found;
+						std::copy(
+								std::begin(other.positions),
+								std::end(other.positions),
+								positions
+							);
 						return *this;
 					}
 
@@ -151,37 +155,78 @@ namespace Rtree
 					// Entries intersecting query
 					std::array<BS, (C + 63)/bss> bitset;
 
+					// Bit set block being handed out
+					unsigned current;
+
+					// Positions of the set bits in the current block, the next
+					// one to hand out and the number found
+					std::uint8_t positions[bss + 16];
+					unsigned char next;
+					unsigned char found;
+
 
 					/**
-					 * Scans through the bitset until the next matching entry is
-					 * found.
+					 * Moves on to the next matching entry.
 					 *
-					 * Scan forward through the bitset and locate the next set
-					 * bit. Reset the bit and update the index to the location
-					 * found.
+					 * The positions of all set bits in a bit set block are
+					 * written at once, and then handed out one at a time. Stops
+					 * at the end of the node.
 					 */
 					void findNext()
 					{
 						unsigned& index = entry.index;
-						const FullScanNode * node = entry.node;
-						unsigned block = index / bss;
-
-						while (index < node->getSize()) {
+						const BasicFullScanNode * node = entry.node;
 
-							if (bitset[block]) {
-								// Find least significant non-zero bit
-								unsigned i = bitScanForward<BS>(bitset[block]);
-								bitset[block] ^= (1ll << i);
-								index = bss * block + i;
-								break;
+						while (next == found) {
+							if (bss * ++current >= node->getSize()) {
+								index = node->getSize();
+								return;
 							}
 
-							index = bss * (++block);
+							next = 0;
+							found = L::compress(bitset[current], positions);
 						}
 
-						// None found?
-						if (index > node->getSize()) {
-							index = node->getSize();
+						// Bits past the last entry may be set
+						index = std::min(
+								bss * current + positions[next++],
+								node->getSize()
+							);
+					}
+
+
+					/**
+					 * Compare the bottom and top strips of all dimensions
+					 * against a reference value each.
+					 *
+					 * @tparam BOTTOM_OP Compare operation for the bottoms
+					 * @tparam TOP_OP Compare operation for the tops
+					 *
+					 * @param base Pointer to the first strip
+					 * @param bottoms Reference values for the bottoms
+					 * @param tops Reference values for the tops
+					 * @param blocks Number of blocks to scan
+					 */
+					template<unsigned BOTTOM_OP, unsigned TOP_OP>
+					void scanStrips(
+							const double * base,
+							const double * bottoms,
+							const double * tops,
+							const unsigned& blocks
+						)
+					{
+						for (unsigned d = 0; d < D; ++d) {
+							scanStrip<BOTTOM_OP>(
+									base + 2 * d * BLOCK_SIZE * N_BLOCKS,
+									&bottoms[d],
+									blocks
+								);
+
+							scanStrip<TOP_OP>(
+									base + (2 * d + 1) * BLOCK_SIZE * N_BLOCKS,
+									&tops[d],
+									blocks
+								);
 						}
 					}
 
@@ -207,48 +252,20 @@ namespace Rtree
 					{
 						static_assert(bss % BLOCK_SIZE == 0);
 
-						// Load reference value
-						__m256d reference = _mm256_broadcast_sd(value);
-
 						unsigned b = 0;
 
 						// Scan entire bit set blocks while possible
 						while (BLOCK_SIZE * blocks - b > bss) {
-							BS results = 0;
-
-							for (unsigned i = 0; i < bss; i += BLOCK_SIZE) {
-								// Load subject value
-								__m256d subject = _mm256_load_pd(
-										base + b + i
-									);
-
-								// Compare and update bitset
-								results |= ((BS)_mm256_movemask_pd(
-										_mm256_cmp_pd(subject, reference, OP)
-									)) << i;
-							}
-
-							bitset[b / bss] &= results;
+							bitset[b / bss] &= L::template strip<OP>(
+									base + b, value, bss
+								);
 							b += bss;
 						}
 
 						// Handle the remaining blocks
-						BS results = 0;
-
-						for (unsigned i = 0; i < blocks * BLOCK_SIZE - b; i += BLOCK_SIZE) {
-							// Load subject value
-							__m256d subject = _mm256_load_pd(
-									base + b + i
-								);
-
-							// Compare and update bitset
-							results |= ((BS) _mm256_movemask_pd(
-									_mm256_cmp_pd(subject, reference, OP)
-								)) << i;
-
-						}
-
-						bitset[b / bss] &= results;
+						bitset[b / bss] &= L::template strip<OP>(
+								base + b, value, blocks * BLOCK_SIZE - b
+							);
 					}
 
 			};
@@ -262,23 +279,76 @@ namespace Rtree
 			template<class E>
 			std::pair<ScanIterator, ScanIterator> scan(
 					const Mbr& mbr,
-					const E&
+					const E&,
+					Predicate predicate = Predicate::INTERSECTS
 				) const
 			{
 				return std::make_pair(
-						ScanIterator(this, mbr, 0),
+						ScanIterator(this, mbr, 0, predicate),
 						ScanIterator(this, mbr, getSize())
 					);
 			}
 
 
+			/**
+			 * Test a batch of queries against every entry in this node.
+			 *
+			 * Each block is compared against all the queries while it is in
+			 * cache, a vector of entries at a time.
+			 *
+			 * @see BaseNode::scanBatch
+			 */
+			template<class E>
+			void scanBatch(
+					const Mbr * queries,
+					std::uint64_t active,
+					std::uint64_t * masks,
+					const E&
+				) const
+			{
+				for (unsigned block = 0; block < N_BLOCKS; ++block) {
+					const unsigned first = block * BLOCK_SIZE;
+
+					if (first >= getSize()) {
+						break;
+					}
+
+					std::uint64_t lanes[BLOCK_SIZE] = {};
+
+					for (std::uint64_t rest = active; rest; rest &= rest - 1) {
+						unsigned q = __builtin_ctzll(rest);
+
+						// The strips of a dimension are as far apart as the
+						// bottoms and tops of the vectorized layout
+						unsigned bitset = L::template block<_CMP_LE_OS, _CMP_GE_OS>(
+								coordinates + first,
+								BLOCK_SIZE * N_BLOCKS,
+								D,
+								queries[q].getTop(),
+								queries[q].getBottom()
+							);
+
+						for (; bitset; bitset &= bitset - 1) {
+							lanes[__builtin_ctz(bitset)] |= std::uint64_t(1) << q;
+						}
+					}
+
+					const unsigned n = std::min(
+							getSize() - first,
+							unsigned(BLOCK_SIZE)
+						);
+					std::copy(lanes, lanes + n, masks + first);
+				}
+			}
+
+
 			/**
 			 * Override new operator to make sure memory is aligned.
 			 */
 			void * operator new(std::size_t count)
 			{
 				void * p;
-				int error = posix_memalign(&p, sizeof(__m256d), count);
+				int error = posix_memalign(&p, alignof(BasicFullScanNode), count);
 
 				// Convert C-style error to exception
 				if (error) {
@@ -286,7 +356,7 @@ namespace Rtree
 				}
 
 				//TODO: Remove
-				if (reinterpret_cast<uintptr_t>(p) % sizeof(__m256d) != 0) {
+				if (reinterpret_cast<uintptr_t>(p) % alignof(BasicFullScanNode) != 0) {
 					throw std::runtime_error("Unaligned memory :-(");
 				}
 
@@ -338,7 +408,7 @@ namespace Rtree
 			{
 				std::array<Coordinate, D> top, bottom;
 
-				auto base = reinterpret_cast<const double *>(coordinates) + index;
+				auto base = coordinates + index;
 
 				for (unsigned d = 0; d < D; ++d) {
 					bottom[d] = base[0];
@@ -360,7 +430,7 @@ namespace Rtree
 				auto top = m.getTop();
 				auto bottom = m.getBottom();
 
-				auto base = reinterpret_cast<double *>(coordinates) + index;
+				auto base = coordinates + index;
 
 				for (unsigned d = 0; d < D; ++d) {
 					base[0] = bottom[d];
@@ -393,9 +463,28 @@ namespace Rtree
 
 
 		private:
-			__m256d coordinates[N_BLOCKS * 2 * D];
+			alignas(BLOCK_SIZE * sizeof(Coordinate))
+				Coordinate coordinates[N_BLOCKS * 2 * D * BLOCK_SIZE];
 			Link links[C];
-			Plugin plugins[C];
+			PluginArray<Plugin, C> plugins;
 	};
 
+
+	/**
+	 * Full scan node comparing four entries at a time with AVX2, or blocks of
+	 * eight with the widest vectors found at runtime when the build does not
+	 * target AVX2.
+	 */
+	template<unsigned D, unsigned C, class P = EntryPlugin>
+	using FullScanNode = BasicFullScanNode<D, C, P, Spatial::DefaultLanes>;
+
+
+#ifdef __AVX512F__
+	/**
+	 * Full scan node comparing eight entries at a time with AVX-512.
+	 */
+	template<unsigned D, unsigned C, class P = EntryPlugin>
+	using FullScanNode512 = BasicFullScanNode<D, C, P, Spatial::Avx512Lanes>;
+#endif
+
 }
@@ -4,10 +4,43 @@
 Test(FullScanNode, data_retainment)
 {
 	testRetainment<FullScanNode>();
+#ifdef __AVX512F__
+	testRetainment<FullScanNode512>();
+#endif
 }
 
 
 Test(FullScanNode, scan)
 {
 	testScanning<FullScanNode>();
+#ifdef __AVX512F__
+	testScanning<FullScanNode512>();
+#endif
+}
+
+
+Test(FullScanNode, scan_batch)
+{
+	testBatchScanning<FullScanNode>();
+#ifdef __AVX512F__
+	testBatchScanning<FullScanNode512>();
+#endif
+}
+
+
+Test(FullScanNode, scan_predicates)
+{
+	testPredicateScanning<FullScanNode>();
+#ifdef __AVX512F__
+	testPredicateScanning<FullScanNode512>();
+#endif
+}
+
+
+Test(FullScanNode, scan_distance)
+{
+	testDistanceScanning<FullScanNode>();
+#ifdef __AVX512F__
+	testDistanceScanning<FullScanNode512>();
+#endif
 }
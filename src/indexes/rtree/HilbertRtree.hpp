@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <cassert>
 #include <vector>
 #include "Rtree.hpp"
@@ -71,7 +72,7 @@ class HilbertRtree : public Rtree<Node>
 			// Single entry - add new root
 			if (getHeight() == 1) {
 				addLevel(
-						Entry<N>(new N({getRoot(), entry}))
+						Entry<N>(createNode({getRoot(), entry}))
 					);
 
 				N& root = getRoot().getNode();
@@ -131,7 +132,7 @@ class HilbertRtree : public Rtree<Node>
 				}
 
 				// No space left - create a new node
-				entry = Entry<N>(new N({entry}));
+				entry = Entry<N>(createNode({entry}));
 				redistribute(range.first, range.second, &entry);
 
 				top++;
@@ -159,9 +160,194 @@ class HilbertRtree : public Rtree<Node>
 
 	protected:
 
+		using Base::createNode;
+		using Base::destroyNode;
+		using Base::distribute;
+		using Base::nodeCount;
+		using Base::patch;
+
 		Box bounds;
 
 
+		/**
+		 * Create a leaf entry with the Hilbert value of the object's center.
+		 *
+		 * @param object Data object to create entry for
+		 * @return New entry for object
+		 */
+		Entry<N> createEntry(const DataObject& object) const override
+		{
+			return Entry<N>(object, bounds);
+		}
+
+
+		/**
+		 * Pack a level of entries in Hilbert order (packed Hilbert R-tree).
+		 *
+		 * The leaf entries are sorted by Hilbert value once and cut into
+		 * consecutive runs. The new parents are created in the same order, so
+		 * the upper levels need no sorting. Every node thus ends up sorted,
+		 * just as if the entries had been inserted one by one.
+		 *
+		 * @param entries Entries to pack (may be reordered)
+		 * @param parents Destination for the entries of the new nodes
+		 */
+		void pack(
+				std::vector<Entry<N>>& entries,
+				std::vector<Entry<N>>& parents
+			) override
+		{
+			if (!std::is_sorted(entries.begin(), entries.end(), HilbertCompare())) {
+				std::sort(entries.begin(), entries.end(), HilbertCompare());
+			}
+
+			distribute(
+					entries.begin(), entries.end(),
+					nodeCount(entries.size()),
+					parents
+				);
+		}
+
+
+		/**
+		 * Split entries into Hilbert ranges for parallel bulk loading.
+		 *
+		 * Consecutive partitions then cover consecutive Hilbert ranges, such
+		 * that the packed partitions together are in Hilbert order.
+		 *
+		 * @param first Iterator to first entry
+		 * @param middle Where to split the range
+		 * @param last Past-the-end iterator
+		 */
+		void split(
+				typename std::vector<Entry<N>>::iterator first,
+				typename std::vector<Entry<N>>::iterator middle,
+				typename std::vector<Entry<N>>::iterator last,
+				unsigned
+			) const override
+		{
+			std::nth_element(first, middle, last, HilbertCompare());
+		}
+
+
+		/**
+		 * Condense the tree by borrowing from cooperating siblings.
+		 *
+		 * A node less than half full shares entries with the s siblings used
+		 * when splitting. If the siblings have room for all its entries, the
+		 * node is merged into them and removed (s to s-1 nodes). Otherwise,
+		 * the entries are distributed evenly among the siblings. Hence there
+		 * are never any orphans to reinsert.
+		 *
+		 * @param path Iterators to the entries of the nodes below the root
+		 *        which lost an entry, the deepest last
+		 */
+		void condense(
+				std::vector<NIt>& path,
+				std::vector<Entry<N>>&
+			) override
+		{
+			while (!path.empty()) {
+				NIt entry = path.back();
+				N& node = entry->getNode();
+
+				if (node.getSize() >= N::capacity / 2) {
+					entry->recalculate();
+					path.pop_back();
+					continue;
+				}
+
+				std::pair<NIt, NIt> range = calculateNeighborRange(entry);
+				std::size_t total = 0;
+
+				for (NIt it = range.first; it != range.second; ++it) {
+					total += it->getNode().getSize();
+				}
+
+				std::size_t nodes = range.second - range.first;
+
+				if (total <= (nodes - 1) * N::capacity) {
+					merge(entry, range);
+				} else {
+					redistribute(range.first, range.second);
+				}
+
+				path.pop_back();
+			}
+		}
+
+
+		/**
+		 * Replace a data entry in place if the Hilbert order allows it.
+		 *
+		 * The new Hilbert value must stay between those of its neighbours in
+		 * the leaf. The first (last) entry of a leaf may only increase
+		 * (decrease) its value, such that the ranges of the leaves are kept
+		 * intact. Moving to siblings would break the order and is not tried.
+		 * The MBRs must allow patching as well (see `Rtree::patch`).
+		 *
+		 * @param path Path to the data entry (see `findPath`)
+		 * @param entry New entry for the data object
+		 * @return True if the entry was replaced
+		 */
+		bool relocate(
+				std::vector<NIt>& path,
+				const Entry<N>& entry
+			) override
+		{
+			NIt object = path.back();
+			N& leaf = object.getContainingNode();
+
+			const std::uint64_t value = entry.getPlugin().getHilbertValue();
+
+			NIt lower = object == leaf.begin() ? object : object - 1;
+			NIt upper = object + 1 == leaf.end() ? object : object + 1;
+
+			if (
+					value < lower->getPlugin().getHilbertValue() ||
+					value > upper->getPlugin().getHilbertValue()
+			) {
+				return false;
+			}
+
+			return patch(path, entry);
+		}
+
+
+		/**
+		 * Merge the node of an entry into its siblings and remove it.
+		 *
+		 * @param entry Entry of node to remove
+		 * @param range Siblings of entry (including it) with enough space
+		 */
+		void merge(NIt entry, std::pair<NIt, NIt> range)
+		{
+			N& node = entry->getNode();
+			std::vector<Entry<N>> entries (node.begin(), node.end());
+
+			entry.getContainingNode().erase(entry);
+			destroyNode(&node);
+			--range.second;
+
+			if (range.first == range.second) {
+				return;
+			}
+
+			// Fill the free space of the siblings and sort them out afterwards
+			NIt destination = range.first;
+
+			for (const Entry<N>& e : entries) {
+				while (destination->getNode().isFull()) {
+					++destination;
+				}
+
+				destination->getNode().add(e);
+			}
+
+			redistribute(range.first, range.second);
+		}
+
+
 		/**
 		 * Split the root node.
 		 *
@@ -172,9 +358,9 @@ class HilbertRtree : public Rtree<Node>
 		 */
 		void splitRoot(Entry<N> entry)
 		{
-			entry = Entry<N>(new N({entry}));
+			entry = Entry<N>(createNode({entry}));
 
-			Entry<N> newRoot (new N({getRoot(), entry}));
+			Entry<N> newRoot (createNode({getRoot(), entry}));
 			redistribute(
 					newRoot.getNode().begin(),
 					newRoot.getNode().end()
@@ -0,0 +1,174 @@
+#include <criterion/criterion.h>
+#include "HilbertRtree.hpp"
+#include "HilbertEntryPlugin.hpp"
+#include "DefaultNode.hpp"
+#include "spatial/RangeQuery.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace Rtree;
+
+using N = DefaultNode<2, 8, HilbertEntryPlugin>;
+using Tree = HilbertRtree<N, 2>;
+
+const Box bounds (Point {0.0, 0.0}, Point {100.0, 100.0});
+
+
+/**
+ * Generate a set of small random objects.
+ */
+std::vector<DataObject> generateObjects(unsigned n, unsigned firstId = 1)
+{
+	std::default_random_engine engine (n);
+	std::uniform_real_distribution<double> distribution (0.0, 99.0);
+	std::vector<DataObject> objects;
+
+	for (unsigned i = 0; i < n; ++i) {
+		Point p (2, distribution, engine);
+
+		objects.emplace_back(
+				firstId + i,
+				Box(p, Point {p[0] + 1.0, p[1] + 1.0})
+			);
+	}
+
+	return objects;
+}
+
+
+/**
+ * Check that the tree gives the same results as a scan through the objects.
+ */
+void checkSearch(const Tree& tree, const std::vector<DataObject>& objects)
+{
+	for (unsigned i = 0; i < 20; ++i) {
+		Box box (
+				Point {4.5 * i, 3.0 * i},
+				Point {4.5 * i + 10.0, 3.0 * i + 15.0}
+			);
+
+		Results expected;
+
+		for (const DataObject& object : objects) {
+			if (object.getBox().intersects(box)) {
+				expected.push_back(object.getId());
+			}
+		}
+
+		std::sort(expected.begin(), expected.end());
+
+		Results results;
+		tree.search(results, RangeQuery(i, box));
+		std::sort(results.begin(), results.end());
+
+		cr_expect_eq(
+				results,
+				expected,
+				"Tree should give the same results as a scan"
+			);
+	}
+}
+
+
+Test(HilbertRtree, packed_order)
+{
+	Tree tree (bounds);
+	tree.bulkLoad(generateObjects(1000));
+	tree.checkStructure();
+
+	N& root = tree.getRoot().getNode();
+
+	cr_expect(
+			std::is_sorted(
+					root.begin(), root.end(),
+					[](const Entry<N>& a, const Entry<N>& b) {
+						return a.getPlugin().getHilbertValue()
+							< b.getPlugin().getHilbertValue();
+					}
+				),
+			"Root children should be sorted by largest Hilbert value"
+		);
+}
+
+
+Test(HilbertRtree, insert_after_packing)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree (bounds);
+	tree.setFillFactor(0.75);
+	tree.bulkLoad(objects);
+
+	for (const DataObject& object : generateObjects(500, 1001)) {
+		tree.insert(object);
+		objects.push_back(object);
+	}
+
+	tree.checkStructure();
+	checkSearch(tree, objects);
+}
+
+
+Test(HilbertRtree, remove)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree (bounds);
+
+	for (const DataObject& object : objects) {
+		tree.insert(object);
+	}
+
+	std::vector<DataObject> remaining;
+
+	for (const DataObject& object : objects) {
+		if (object.getId() % 3) {
+			cr_expect(tree.remove(object), "Object should be removed");
+		} else {
+			remaining.push_back(object);
+		}
+	}
+
+	tree.checkStructure();
+	checkSearch(tree, remaining);
+
+	for (const DataObject& object : remaining) {
+		tree.remove(object);
+	}
+
+	cr_expect_eq(tree.getHeight(), 0u, "Tree should be empty");
+}
+
+
+Test(HilbertRtree, update)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree (bounds);
+	tree.bulkLoad(objects);
+
+	std::default_random_engine engine (3);
+	std::normal_distribution<double> distribution (0.0, 0.5);
+
+	for (DataObject& object : objects) {
+		Point bottom = object.getBox().getPoints().first;
+
+		for (unsigned d = 0; d < 2; ++d) {
+			bottom[d] += distribution(engine);
+			bottom[d] = std::min(std::max(bottom[d], 0.0), 99.0);
+		}
+
+		Box box (bottom, Point {bottom[0] + 1.0, bottom[1] + 1.0});
+
+		cr_expect(
+				tree.update(object.getId(), object.getBox(), box),
+				"Object should be updated"
+			);
+
+		object = DataObject(object.getId(), box);
+	}
+
+	tree.checkStructure();
+	checkSearch(tree, objects);
+}
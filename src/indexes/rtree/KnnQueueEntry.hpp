@@ -18,15 +18,18 @@ struct KnnQueueEntry {
 		Id id;
 	};
 	unsigned elevation;
-	float distance;
+	double distance;
 
-	KnnQueueEntry(Id id, unsigned elevation, float d)
+	KnnQueueEntry(Id id, unsigned elevation, double d)
 		: id(id), elevation(elevation), distance(d) {};
 
-	KnnQueueEntry(N * node, unsigned elevation, float d)
+	KnnQueueEntry(N * node, unsigned elevation, double d)
 		: node(node), elevation(elevation), distance(d) {};
 
 	/**
+	 * Order by distance, used to pop the nearest entry first.
+	 *
+	 * Elevation is the height above the data objects, thus 0 for objects.
 	 */
 	bool operator>(const KnnQueueEntry& other) const
 	{
@@ -3,6 +3,7 @@
 #include "spatial/Box.hpp"
 #include "spatial/Coordinate.hpp"
 #include "spatial/Point.hpp"
+#include "spatial/Predicate.hpp"
 
 using namespace Spatial;
 
@@ -198,6 +199,28 @@ class Mbr
 		};
 
 
+		/**
+		 * Calculate the MBR grown by a distance in every direction.
+		 *
+		 * Covers everything within the distance of this MBR (and the
+		 * corners beyond it).
+		 *
+		 * @param distance Distance to grow by
+		 * @return Grown MBR
+		 */
+		Mbr expanded(double distance) const
+		{
+			Mbr result;
+
+			for (unsigned i = 0; i < D; i++) {
+				result.top[i] = top[i] + distance;
+				result.bottom[i] = bottom[i] - distance;
+			}
+
+			return result;
+		};
+
+
 		/**
 		 * Check whether this MBR contains another.
 		 *
@@ -216,6 +239,28 @@ class Mbr
 		};
 
 
+		/**
+		 * Check whether this MBR relates to a query as given by a predicate.
+		 *
+		 * @param query Query MBR
+		 * @param predicate Relation between this and the query
+		 * @return True if this matches the query
+		 */
+		bool matches(const Mbr& query, Predicate predicate) const
+		{
+			switch (predicate) {
+				case Predicate::CONTAINS:
+					return contains(query);
+
+				case Predicate::WITHIN:
+					return query.contains(*this);
+
+				default:
+					return intersects(query);
+			}
+		};
+
+
 		/**
 		 * Calculates the intersection complexity.
 		 *
@@ -316,6 +361,17 @@ class Mbr
 		}
 
 
+		/**
+		 * Convert this MBR back to an axis aligned box.
+		 *
+		 * @return Box covering the same area
+		 */
+		Box toBox() const
+		{
+			return Box(Point(bottom, bottom + D), Point(top, top + D));
+		}
+
+
 		/**
 		 * Get bottom coordinates.
 		 */
@@ -150,6 +150,29 @@ Test(mbr, intersection)
 		);
 }
 
+Test(mbr, expanded)
+{
+	Mbr<2> mbr = Box(Point({1.0f, 2.0f}), Point({3.0f, 4.0f}));
+	Mbr<2> near (Point({4.5f, 3.0f}));
+
+	cr_assert_float_eq(
+			mbr.expanded(1.0f).volume(),
+			16.0f,
+			EPSILON,
+			"Expanding should grow each side by the distance"
+		);
+
+	cr_assert(
+			mbr.expanded(1.5f).intersects(near),
+			"Expanding by the distance should reach a point that far away"
+		);
+
+	cr_assert_not(
+			mbr.expanded(1.4f).intersects(near),
+			"Expanding by less should not reach the point"
+		);
+}
+
 Test(mbr, perimeter)
 {
 	cr_assert_float_eq(
@@ -126,3 +126,180 @@ void testScanning()
 			);
 	}
 }
+
+
+/**
+ * Check that a batch scan gives the same result as a scan per query.
+ */
+template<template<unsigned, unsigned, class> class Node>
+void testBatchScanning()
+{
+	using N = Node<2, 100, EntryPlugin>;
+	Entry<N> parent (
+			Mbr<2>({1e100, 1e100}, {1e-100, 1e-100}),
+			nullptr
+		);
+
+	N node;
+
+	// Leave the last block partially filled
+	auto originals = generateData<N>(N::capacity - 1);
+
+	for (const Entry<N>& e : originals) {
+		node.add(e);
+	}
+
+	// One query per bit, overlapping a few entries each
+	std::vector<Mbr<2>> queries;
+
+	for (unsigned q = 0; q < 64; ++q) {
+		queries.push_back(Box(
+				Point {1.5f * q, 3.0f * q},
+				Point {1.5f * q + 4.0f, 3.0f * q + 10.0f}
+			));
+	}
+
+	// Leave every third query out of the batch
+	std::uint64_t active = 0;
+
+	for (unsigned q = 0; q < 64; ++q) {
+		if (q % 3) {
+			active |= std::uint64_t(1) << q;
+		}
+	}
+
+	std::uint64_t masks[N::capacity];
+	node.scanBatch(queries.data(), active, masks, parent);
+
+	for (unsigned i = 0; i < originals.size(); ++i) {
+		std::uint64_t expected = 0;
+
+		for (unsigned q = 0; q < 64; ++q) {
+			if ((active >> q) & 1 && originals[i].getMbr().intersects(queries[q])) {
+				expected |= std::uint64_t(1) << q;
+			}
+		}
+
+		cr_expect_eq(
+				masks[i],
+				expected,
+				"Batch scan should match the queries intersecting entry %u",
+				i
+			);
+	}
+}
+
+
+/**
+ * Check that scans for containment give the matching entries.
+ */
+template<template<unsigned, unsigned, class> class Node>
+void testPredicateScanning()
+{
+	using N = Node<2, 100, EntryPlugin>;
+
+	N node;
+
+	auto originals = generateData<N>(N::capacity);
+
+	for (const Entry<N>& e : originals) {
+		node.add(e);
+	}
+
+	// Pruning nodes use the MBR of the parent
+	Entry<N> parent (&node);
+
+	for (unsigned i = 0; i < N::capacity; i += 7) {
+		// Queries within a few entries, and a few entries within them
+		std::vector<std::pair<Mbr<2>, Predicate>> queries {
+				{Box(
+						Point {1.5f * i, 4.0f * i},
+						Point {1.5f * i + 0.1f, 4.0f * i + 0.1f}
+					), Predicate::CONTAINS},
+				{Box(
+						Point {0.5f * i, 1.5f * i},
+						Point {2.5f * i, 6.0f * i}
+					), Predicate::WITHIN},
+				{Box(
+						Point {0.5f * i, 1.5f * i},
+						Point {2.5f * i, 6.0f * i}
+					), Predicate::INTERSECTS}
+			};
+
+		for (const auto& query : queries) {
+			std::vector<Link<N>> results;
+
+			for (const Entry<N>& c : originals) {
+				if (c.getMbr().matches(query.first, query.second)) {
+					results.push_back(c.getLink());
+				}
+			}
+
+			auto scanRange = node.scan(query.first, parent, query.second);
+			auto rit = results.begin();
+			auto sit = scanRange.first;
+
+			while (rit != results.end() && sit != scanRange.second) {
+				cr_expect_eq(
+						rit->getId(),
+						sit->getId(),
+						"Results should be equal"
+					);
+
+				++rit;
+				++sit;
+			}
+
+			cr_expect(
+					rit == results.end() && sit == scanRange.second,
+					"Scan should give all matching entries for query %u",
+					i
+				);
+		}
+	}
+}
+
+
+/**
+ * Test measuring the distance to all entries in a node.
+ */
+template<template<unsigned, unsigned, class> class Node>
+void testDistanceScanning()
+{
+	using N = Node<2, 100, EntryPlugin>;
+
+	N node;
+
+	// Leave the last block partially filled
+	auto originals = generateData<N>(N::capacity - 3);
+
+	for (const Entry<N>& e : originals) {
+		node.add(e);
+	}
+
+	for (unsigned i = 0; i < N::capacity; i += 7) {
+		Mbr<2> query = Box(
+				Point {1.5f * i, 4.0f * i},
+				Point {1.5f * i + 2.0f, 4.0f * i + 0.5f}
+			);
+
+		std::vector<double> distances (N::capacity, -1.0);
+		node.scanDistance(query, distances.data());
+
+		for (unsigned j = 0; j < originals.size(); ++j) {
+			cr_expect_float_eq(
+					distances[j],
+					originals[j].getMbr().distance2(query),
+					1e-9,
+					"Distance to entry %u should match for query %u",
+					j, i
+				);
+		}
+
+		cr_expect_eq(
+				distances[originals.size()],
+				-1.0,
+				"Distances past the last entry should not be written"
+			);
+	}
+}
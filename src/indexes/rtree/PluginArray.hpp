@@ -0,0 +1,58 @@
+#pragma once
+#include <type_traits>
+
+
+namespace Rtree
+{
+
+	/**
+	 * Storage for the plugins of the entries in a node.
+	 *
+	 * Works like a plain array of plugins. Plugins without any state (such
+	 * as the default `EntryPlugin`) are all equal, thus a single one is kept
+	 * for all entries, such that no room is wasted on them.
+	 *
+	 * @tparam P Plugin
+	 * @tparam C Node capacity
+	 */
+	template<class P, unsigned C, bool = std::is_empty<P>::value>
+	class PluginArray
+	{
+		public:
+			P& operator[](unsigned i)
+			{
+				return plugins[i];
+			}
+
+			const P& operator[](unsigned i) const
+			{
+				return plugins[i];
+			}
+
+		private:
+			P plugins[C];
+	};
+
+
+	/**
+	 * Plugin storage for plugins without state.
+	 */
+	template<class P, unsigned C>
+	class PluginArray<P, C, true>
+	{
+		public:
+			P& operator[](unsigned)
+			{
+				return plugin;
+			}
+
+			const P& operator[](unsigned) const
+			{
+				return plugin;
+			}
+
+		private:
+			P plugin;
+	};
+
+}
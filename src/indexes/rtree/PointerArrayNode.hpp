@@ -1,5 +1,6 @@
 #pragma once
 #include "BaseNode.hpp"
+#include "PluginArray.hpp"
 #include "PointerArrayNode.hpp"
 
 
@@ -50,7 +51,7 @@ namespace Rtree
 					}
 
 					/**
-					 * Construct a scan iterator yielding entries overlapping
+					 * Construct a scan iterator yielding entries matching an
 					 * MBR.
 					 *
 					 * Note that only a reference to the given MBR is store,
@@ -58,14 +59,16 @@ namespace Rtree
 					 * iterator.
 					 *
 					 * @param node Node to scan through
-					 * @param mbr MBR yielded entries must overlap
+					 * @param mbr MBR yielded entries must match
 					 * @param i Index to start at
+					 * @param predicate Relation between entries and MBR
 					 */
 					ScanIterator(
 							const PointerArrayNode * node,
 							const Mbr * mbr,
-							unsigned index
-						) : Base(node, index), mbr(mbr)
+							unsigned index,
+							Predicate predicate = Predicate::INTERSECTS
+						) : Base(node, index), mbr(mbr), predicate(predicate)
 					{
 						findNext();
 					};
@@ -103,12 +106,13 @@ namespace Rtree
 
 				private:
 					const Mbr * mbr;
+					Predicate predicate;
 
 					/**
-					 * Finds the first position intersecting with the MBR.
+					 * Finds the first position matching the MBR.
 					 *
-					 * This includes the current position if it intersects with
-					 * the MBR. `i` is updated to the found position.
+					 * This includes the current position if it matches the
+					 * MBR. `i` is updated to the found position.
 					 */
 					void findNext()
 					{
@@ -116,7 +120,7 @@ namespace Rtree
 						const PointerArrayNode * node = entry.node;
 						while (
 							index < node->getSize() &&
-							!node->mbrs[index].intersects(*mbr)
+							!node->mbrs[index].matches(*mbr, predicate)
 						) {
 							++index;
 						}
@@ -130,11 +134,12 @@ namespace Rtree
 			template<class E>
 			std::pair<ScanIterator, ScanIterator> scan(
 					const Mbr& mbr,
-					const E&
+					const E&,
+					Predicate predicate = Predicate::INTERSECTS
 				) const
 			{
 				return std::make_pair(
-						ScanIterator(this, &mbr, 0),
+						ScanIterator(this, &mbr, 0, predicate),
 						ScanIterator(this, nullptr, getSize())
 					);
 			}
@@ -212,7 +217,7 @@ namespace Rtree
 		private:
 			Mbr mbrs[C];
 			Link links[C];
-			Plugin plugins[C];
+			PluginArray<Plugin, C> plugins;
 	};
 
 }
@@ -1,10 +1,11 @@
 #pragma once
 #include "BaseNode.hpp"
+#include "PluginArray.hpp"
 #include "ProxyScanIterator.hpp"
 #include "spatial/Coordinate.hpp"
+#include "spatial/Lanes.hpp"
 #include "immintrin.h"
 
-//TODO: BFS
 #include "FullScanNode.hpp"
 
 namespace Rtree
@@ -14,14 +15,19 @@ namespace Rtree
 	 * Represents a vectorized node where an arrays of subfields approach has
 	 * been combined with vectorized scans (and full node scans).
 	 *
+	 * Use the `PruningNode` (AVX2, or picked at runtime when the build does
+	 * not target it) and `PruningNode512` (AVX-512) aliases to pick the vectors.
+	 *
 	 * @tparam D Dimension
 	 * @tparam C Max capacity
 	 * @tparam P Plugin
+	 * @tparam L Vector kernels (e.g. Spatial::Avx2Lanes)
 	 */
-	template<unsigned D, unsigned C, class P = EntryPlugin>
-	class PruningNode : public BaseNode<PruningNode<D, C, P>, C, P>
+	template<unsigned D, unsigned C, class P, class L>
+	class BasicPruningNode
+		: public BaseNode<BasicPruningNode<D, C, P, L>, C, P>
 	{
-		using Base = BaseNode<PruningNode<D, C, P>, C, P>;
+		using Base = BaseNode<BasicPruningNode<D, C, P, L>, C, P>;
 		using Coordinate = Spatial::Coordinate;
 
 
@@ -30,13 +36,13 @@ namespace Rtree
 				"Vector node assumes doubles"
 			);
 
-		static constexpr unsigned BLOCK_SIZE = 4;
+		static constexpr unsigned BLOCK_SIZE = L::WIDTH;
 		static constexpr unsigned N_BLOCKS = (C + BLOCK_SIZE - 1) / BLOCK_SIZE;
 
 
 		public:
 			using Mbr = ::Rtree::Mbr<D>;
-			using Link = ::Rtree::Link<PruningNode>;
+			using Link = ::Rtree::Link<BasicPruningNode>;
 			using Plugin = P;
 
 			// Inherit constructor and operator=
@@ -47,11 +53,11 @@ namespace Rtree
 			using Base::getSize;
 
 
-			class ScanIterator : public ProxyScanIterator<PruningNode>
+			class ScanIterator : public ProxyScanIterator<BasicPruningNode>
 			{
 				// Bit set block type
 				using BS = unsigned;
-				using Base = ProxyScanIterator<PruningNode>;
+				using Base = ProxyScanIterator<BasicPruningNode>;
 				using Base::entry;
 
 				// Number of bits in each bit set block
@@ -65,10 +71,11 @@ namespace Rtree
 					 * index.
 					 */
 					ScanIterator(
-							const PruningNode * node,
+							const BasicPruningNode * node,
 							const Mbr& mbr,
 							unsigned index,
-							const Mbr& parent
+							const Mbr& parent,
+							Predicate predicate = Predicate::INTERSECTS
 						) : Base(node, index)
 					{
 						if (index >= node->getSize()) {
@@ -83,43 +90,51 @@ namespace Rtree
 							bitset[i] = ~0;
 						}
 
-						const double * base = reinterpret_cast<const double *>(
-								node->coordinates
-							);
+						const double * base = node->coordinates;
 
 						auto highs = mbr.getTop();
 						auto lows = mbr.getBottom();
 						unsigned blocks = (node->getSize() + BLOCK_SIZE - 1) / BLOCK_SIZE;
 
-						// Compare across all dimensions
-						for (unsigned d = 0; d < D; ++d) {
+						switch (predicate) {
+							case Predicate::CONTAINS:
+								scanStrips<_CMP_LE_OS, _CMP_GE_OS>(
+										base, lows, highs, parent, blocks
+									);
+								break;
 
-							if (highs[d] < parent.getTop()[d]) {
-								// Check top of query
-								scanStrip<_CMP_LE_OS>(
-										base + 2 * d * BLOCK_SIZE * N_BLOCKS,
-										&highs[d],
-										blocks
+							case Predicate::WITHIN:
+								scanStrips<_CMP_GE_OS, _CMP_LE_OS>(
+										base, lows, highs, parent, blocks
 									);
-							}
+								break;
 
-							if (lows[d] > parent.getBottom()[d]) {
-								// Check bottom of query
-								scanStrip<_CMP_GE_OS>(
-										base + (2 * d + 1) * BLOCK_SIZE * N_BLOCKS,
-										&lows[d],
-										blocks
+							default:
+								// Check top and bottom of query
+								scanStrips<_CMP_LE_OS, _CMP_GE_OS>(
+										base, highs, lows, parent, blocks
 									);
-							}
 						}
 
+						current = 0;
+						next = 0;
+						found = L::compress(bitset[0], positions);
+
 						findNext();
 					};
 
 					ScanIterator& operator=(const ScanIterator& other)
 					{
-						ProxyScanIterator<PruningNode>::operator=(other);
+						ProxyScanIterator<BasicPruningNode>::operator=(other);
 						bitset = other.bitset;
+						current = other.current;
+						next = other.next;
+						found = other.found;
+						std::copy(
+								std::begin(other.positions),
+								std::end(other.positions),
+								positions
+							);
 						return *this;
 					}
 
@@ -141,41 +156,114 @@ namespace Rtree
 					// Entries intersecting query
 					std::array<BS, (C + 63)/bss> bitset;
 
+					// Bit set block being handed out
+					unsigned current;
+
+					// Positions of the set bits in the current block, the next
+					// one to hand out and the number found
+					std::uint8_t positions[bss + 16];
+					unsigned char next;
+					unsigned char found;
+
 
 					/**
-					 * Scans through the bitset until the next matching entry is
-					 * found.
+					 * Moves on to the next matching entry.
 					 *
-					 * Scan forward through the bitset and locate the next set
-					 * bit. Reset the bit and update the index to the location
-					 * found.
+					 * @see BasicFullScanNode::ScanIterator::findNext
 					 */
 					void findNext()
 					{
 						unsigned& index = entry.index;
-						const PruningNode * node = entry.node;
-						unsigned block = index / bss;
-
-						while (index < node->getSize()) {
+						const BasicPruningNode * node = entry.node;
 
-							if (bitset[block]) {
-								// Find least significant non-zero bit
-								unsigned i = bitScanForward<BS>(bitset[block]);
-								bitset[block] ^= (1ll << i);
-								index = bss * block + i;
-								break;
+						while (next == found) {
+							if (bss * ++current >= node->getSize()) {
+								index = node->getSize();
+								return;
 							}
 
-							index = bss * (++block);
+							next = 0;
+							found = L::compress(bitset[current], positions);
 						}
 
-						// None found?
-						if (index > node->getSize()) {
-							index = node->getSize();
+						// Bits past the last entry may be set
+						index = std::min(
+								bss * current + positions[next++],
+								node->getSize()
+							);
+					}
+
+
+					/**
+					 * Compare the bottom and top strips of all dimensions
+					 * against a reference value each.
+					 *
+					 * All bottoms and tops lie within the parent MBR. Strips
+					 * where the parent MBR passes the comparison as a whole
+					 * are thus skipped, e.g. the tops when looking for
+					 * entries within a query reaching above the parent.
+					 *
+					 * @tparam BOTTOM_OP Compare operation for the bottoms
+					 * @tparam TOP_OP Compare operation for the tops
+					 *
+					 * @param base Pointer to the first strip
+					 * @param bottoms Reference values for the bottoms
+					 * @param tops Reference values for the tops
+					 * @param parent MBR of the node
+					 * @param blocks Number of blocks to scan
+					 */
+					template<unsigned BOTTOM_OP, unsigned TOP_OP>
+					void scanStrips(
+							const double * base,
+							const double * bottoms,
+							const double * tops,
+							const Mbr& parent,
+							const unsigned& blocks
+						)
+					{
+						for (unsigned d = 0; d < D; ++d) {
+							if (!passes<BOTTOM_OP>(parent, d, bottoms[d])) {
+								scanStrip<BOTTOM_OP>(
+										base + 2 * d * BLOCK_SIZE * N_BLOCKS,
+										&bottoms[d],
+										blocks
+									);
+							}
+
+							if (!passes<TOP_OP>(parent, d, tops[d])) {
+								scanStrip<TOP_OP>(
+										base + (2 * d + 1) * BLOCK_SIZE * N_BLOCKS,
+										&tops[d],
+										blocks
+									);
+							}
 						}
 					}
 
 
+					/**
+					 * Check whether every coordinate within the parent MBR
+					 * passes a comparison.
+					 *
+					 * @tparam OP Compare operation (_CMP_LE_OS or _CMP_GE_OS)
+					 *
+					 * @param parent MBR of the node
+					 * @param d Dimension
+					 * @param value Reference value
+					 */
+					template<unsigned OP>
+					static bool passes(
+							const Mbr& parent,
+							unsigned d,
+							double value
+						)
+					{
+						return OP == _CMP_LE_OS
+							? parent.getTop()[d] <= value
+							: parent.getBottom()[d] >= value;
+					}
+
+
 					/**
 					 * Scan all blocks in a strip and update bitset.
 					 *
@@ -197,48 +285,20 @@ namespace Rtree
 					{
 						static_assert(bss % BLOCK_SIZE == 0);
 
-						// Load reference value
-						__m256d reference = _mm256_broadcast_sd(value);
-
 						unsigned b = 0;
 
 						// Scan entire bit set blocks while possible
 						while (BLOCK_SIZE * blocks - b > bss) {
-							BS results = 0;
-
-							for (unsigned i = 0; i < bss; i += BLOCK_SIZE) {
-								// Load subject value
-								__m256d subject = _mm256_load_pd(
-										base + b + i
-									);
-
-								// Compare and update bitset
-								results |= ((BS)_mm256_movemask_pd(
-										_mm256_cmp_pd(subject, reference, OP)
-									)) << i;
-							}
-
-							bitset[b / bss] &= results;
+							bitset[b / bss] &= L::template strip<OP>(
+									base + b, value, bss
+								);
 							b += bss;
 						}
 
 						// Handle the remaining blocks
-						BS results = 0;
-
-						for (unsigned i = 0; i < blocks * BLOCK_SIZE - b; i += BLOCK_SIZE) {
-							// Load subject value
-							__m256d subject = _mm256_load_pd(
-									base + b + i
-								);
-
-							// Compare and update bitset
-							results |= ((BS) _mm256_movemask_pd(
-									_mm256_cmp_pd(subject, reference, OP)
-								)) << i;
-
-						}
-
-						bitset[b / bss] &= results;
+						bitset[b / bss] &= L::template strip<OP>(
+								base + b, value, blocks * BLOCK_SIZE - b
+							);
 					}
 
 			};
@@ -252,11 +312,12 @@ namespace Rtree
 			template<class E>
 			std::pair<ScanIterator, ScanIterator> scan(
 					const Mbr& mbr,
-					const E& parent
+					const E& parent,
+					Predicate predicate = Predicate::INTERSECTS
 				) const
 			{
 				return std::make_pair(
-						ScanIterator(this, mbr, 0, parent.getMbr()),
+						ScanIterator(this, mbr, 0, parent.getMbr(), predicate),
 						ScanIterator(this, mbr, getSize(), parent.getMbr())
 					);
 			}
@@ -268,7 +329,7 @@ namespace Rtree
 			void * operator new(std::size_t count)
 			{
 				void * p;
-				int error = posix_memalign(&p, sizeof(__m256d), count);
+				int error = posix_memalign(&p, alignof(BasicPruningNode), count);
 
 				// Convert C-style error to exception
 				if (error) {
@@ -276,7 +337,7 @@ namespace Rtree
 				}
 
 				//TODO: Remove
-				if (reinterpret_cast<uintptr_t>(p) % sizeof(__m256d) != 0) {
+				if (reinterpret_cast<uintptr_t>(p) % alignof(BasicPruningNode) != 0) {
 					throw std::runtime_error("Unaligned memory :-(");
 				}
 
@@ -328,7 +389,7 @@ namespace Rtree
 			{
 				std::array<Coordinate, D> top, bottom;
 
-				auto base = reinterpret_cast<const double *>(coordinates) + index;
+				auto base = coordinates + index;
 
 				for (unsigned d = 0; d < D; ++d) {
 					bottom[d] = base[0];
@@ -350,7 +411,7 @@ namespace Rtree
 				auto top = m.getTop();
 				auto bottom = m.getBottom();
 
-				auto base = reinterpret_cast<double *>(coordinates) + index;
+				auto base = coordinates + index;
 
 				for (unsigned d = 0; d < D; ++d) {
 					base[0] = bottom[d];
@@ -383,9 +444,28 @@ namespace Rtree
 
 
 		private:
-			__m256d coordinates[N_BLOCKS * 2 * D];
+			alignas(BLOCK_SIZE * sizeof(Coordinate))
+				Coordinate coordinates[N_BLOCKS * 2 * D * BLOCK_SIZE];
 			Link links[C];
-			Plugin plugins[C];
+			PluginArray<Plugin, C> plugins;
 	};
 
+
+	/**
+	 * Pruning node comparing four entries at a time with AVX2, or blocks of
+	 * eight with the widest vectors found at runtime when the build does not
+	 * target AVX2.
+	 */
+	template<unsigned D, unsigned C, class P = EntryPlugin>
+	using PruningNode = BasicPruningNode<D, C, P, Spatial::DefaultLanes>;
+
+
+#ifdef __AVX512F__
+	/**
+	 * Pruning node comparing eight entries at a time with AVX-512.
+	 */
+	template<unsigned D, unsigned C, class P = EntryPlugin>
+	using PruningNode512 = BasicPruningNode<D, C, P, Spatial::Avx512Lanes>;
+#endif
+
 }
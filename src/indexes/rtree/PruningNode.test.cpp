@@ -4,10 +4,43 @@
 Test(PruningNode, data_retainment)
 {
 	testRetainment<PruningNode>();
+#ifdef __AVX512F__
+	testRetainment<PruningNode512>();
+#endif
 }
 
 
 Test(PruningNode, scan)
 {
 	testScanning<PruningNode>();
+#ifdef __AVX512F__
+	testScanning<PruningNode512>();
+#endif
+}
+
+
+Test(PruningNode, scan_batch)
+{
+	testBatchScanning<PruningNode>();
+#ifdef __AVX512F__
+	testBatchScanning<PruningNode512>();
+#endif
+}
+
+
+Test(PruningNode, scan_predicates)
+{
+	testPredicateScanning<PruningNode>();
+#ifdef __AVX512F__
+	testPredicateScanning<PruningNode512>();
+#endif
+}
+
+
+Test(PruningNode, scan_distance)
+{
+	testDistanceScanning<PruningNode>();
+#ifdef __AVX512F__
+	testDistanceScanning<PruningNode512>();
+#endif
 }
@@ -0,0 +1,730 @@
+#pragma once
+#include "BaseNode.hpp"
+#include "PluginArray.hpp"
+#include "ProxyScanIterator.hpp"
+#include "spatial/Coordinate.hpp"
+#include "immintrin.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace Rtree
+{
+
+	/**
+	 * Represents a node keeping the MBRs of its entries as 16 bit offsets on
+	 * a grid over the node (as in the QR-tree).
+	 *
+	 * The node keeps a frame spanning exactly its entries. Each dimension of
+	 * the frame is split into 65535 steps, bottoms are rounded down to a step
+	 * and tops up, thus each stored MBR covers the original one. When the
+	 * entries no longer span the frame, as an entry is added outside of it or
+	 * one at its border is changed or removed, the frame is fitted to them
+	 * again and all entries are rounded onto the new grid. The entries thus
+	 * stay within the MBR of the parent entry, which is no smaller than their
+	 * union.
+	 *
+	 * Queries are rounded onto the same grid, bottoms compared against the
+	 * step at or below the query and tops against the step at or above it.
+	 * This keeps every entry matching the original MBR, and sixteen entries
+	 * are compared at a time with AVX2. Entries just outside a query may
+	 * however match as well, and the parent entries may be slightly larger
+	 * than the union of their children, thus without EXACT the node is not
+	 * `tight` and `Rtree::checkStructure` only checks that parents cover
+	 * their children. Fitting the frame rounds entries a second time, after
+	 * which the rounded MBRs no longer tell whether the original is within a
+	 * query, so WITHIN scans match all entries intersecting the query.
+	 *
+	 * With EXACT set, the original MBRs are kept besides, and each entry
+	 * matching a scan is checked against its original MBR, as by
+	 * `ExactFloatNode`. Use the `QuantizedNode` and `ExactQuantizedNode`
+	 * aliases to pick either.
+	 *
+	 * @tparam D Dimension
+	 * @tparam C Max capacity
+	 * @tparam P Plugin
+	 * @tparam EXACT Whether to check matches against the original MBRs
+	 */
+	template<unsigned D, unsigned C, class P, bool EXACT>
+	class BasicQuantizedNode
+		: public BaseNode<BasicQuantizedNode<D, C, P, EXACT>, C, P>
+	{
+		using Base = BaseNode<BasicQuantizedNode<D, C, P, EXACT>, C, P>;
+		using Coordinate = Spatial::Coordinate;
+		using Offset = std::uint16_t;
+
+		static constexpr unsigned BLOCK_SIZE = 16;
+		static constexpr unsigned N_BLOCKS = (C + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+		// Highest offset, at the top of the frame
+		static constexpr long STEPS = 0xffff;
+
+
+		public:
+			using Mbr = ::Rtree::Mbr<D>;
+			using Link = ::Rtree::Link<BasicQuantizedNode>;
+			using Plugin = P;
+
+			// Parents may be larger than the union of the rounded MBRs
+			static constexpr bool tight = EXACT;
+
+			// Inherit operator=
+			using Base::operator=;
+
+			// Depends on template parameters
+			using Base::getSize;
+
+
+			class ScanIterator : public ProxyScanIterator<BasicQuantizedNode>
+			{
+				using Base = ProxyScanIterator<BasicQuantizedNode>;
+				using Base::entry;
+
+				public:
+					ScanIterator() = default;
+
+					ScanIterator(
+							const BasicQuantizedNode * node,
+							const Mbr& mbr,
+							unsigned index,
+							Predicate predicate = Predicate::INTERSECTS
+						) : Base(node, index), mbr(&mbr), predicate(predicate)
+					{
+						// Rounded MBRs can only rule out containment within
+						// queries they do not intersect
+						if (!EXACT && predicate == Predicate::WITHIN) {
+							this->predicate = Predicate::INTERSECTS;
+						}
+
+						if (index < node->getSize()) {
+							if (!quantize(node, mbr)) {
+								entry.index = node->getSize();
+								return;
+							}
+
+							bitset = scanBlock();
+							findNext();
+						}
+					};
+
+					ScanIterator& operator++()
+					{
+						assert(entry.index < entry.node->getSize());
+
+						next();
+						findNext();
+
+						return *this;
+					}
+
+					ScanIterator operator++(int)
+					{
+						ScanIterator it = *this;
+						operator++();
+						return it;
+					}
+
+				private:
+					const Mbr * mbr;
+					Predicate predicate;
+					unsigned bitset;
+
+					// Reference offsets for the bottoms and tops, zero for
+					// end iterators
+					Offset bottoms[D] = {};
+					Offset tops[D] = {};
+
+
+					/**
+					 * Round the query onto the grid of the node.
+					 *
+					 * @return False if no entry can match
+					 */
+					bool quantize(const BasicQuantizedNode * node, const Mbr& mbr)
+					{
+						// Values compared against the bottoms and tops
+						const Coordinate * lows = mbr.getBottom();
+						const Coordinate * highs = mbr.getTop();
+
+						if (predicate == Predicate::INTERSECTS) {
+							std::swap(lows, highs);
+						}
+
+						for (unsigned d = 0; d < D; ++d) {
+							long bottom = node->floor(d, lows[d]);
+							long top = node->ceil(d, highs[d]);
+
+							// Bottoms at or below the step below the frame,
+							// or tops above the frame?
+							if (
+									predicate != Predicate::WITHIN &&
+									(bottom < 0 || top > STEPS)
+							) {
+								return false;
+							}
+
+							bottoms[d] = std::max(bottom, 0l);
+							tops[d] = top > STEPS ? STEPS : top;
+						}
+
+						return true;
+					}
+
+
+					/**
+					 * Jump to the next position.
+					 *
+					 * This proceeds without any questions asked, and also keeps
+					 * the internal bitset up-to-date.
+					 */
+					void next()
+					{
+						unsigned& index = entry.index;
+
+						bitset >>= 1;
+						++index;
+
+						if (index % BLOCK_SIZE == 0) {
+							bitset = scanBlock();
+						}
+					}
+
+
+					/**
+					 * Scans until the next matching entry is found.
+					 *
+					 * Entries passing the scan are checked against their
+					 * original MBRs if those are kept. Also stops when the end
+					 * of the node is reached.
+					 */
+					void findNext()
+					{
+						unsigned& index = entry.index;
+						const BasicQuantizedNode * node = entry.node;
+
+						while (index < node->getSize()) {
+							if (
+									(bitset & 1) && (
+										!EXACT ||
+										node->getMbr(index).matches(
+											*mbr, predicate
+										)
+									)
+							) {
+								break;
+							}
+
+							next();
+						}
+					}
+
+
+					/**
+					 * Scan the current block and update bitset.
+					 */
+					unsigned scanBlock() const
+					{
+						switch (predicate) {
+							case Predicate::WITHIN:
+								return scanBlock<false, true>();
+
+							default:
+								return scanBlock<true, false>();
+						}
+					}
+
+
+					/**
+					 * Compare the offsets in the current block against the
+					 * reference offsets for each dimension.
+					 *
+					 * @tparam BOTTOM_BELOW Whether bottoms must be at or below
+					 *         the reference (else at or above)
+					 * @tparam TOP_BELOW Whether tops must be at or below the
+					 *         reference (else at or above)
+					 * @return Bitset of entries passing all comparisons
+					 */
+					template<bool BOTTOM_BELOW, bool TOP_BELOW>
+					unsigned scanBlock() const
+					{
+						const unsigned& index = entry.index;
+						const BasicQuantizedNode * node = entry.node;
+
+						const __m256i * base = node->coordinates
+							+ 2 * D * (index / BLOCK_SIZE);
+						__m256i matches = _mm256_set1_epi16(-1);
+
+						// Compare across all dimensions
+						for (unsigned j = 0; j < D; ++j) {
+							matches = _mm256_and_si256(
+									matches,
+									compare<BOTTOM_BELOW>(
+										_mm256_load_si256(base),
+										_mm256_set1_epi16(bottoms[j])
+									)
+								);
+							matches = _mm256_and_si256(
+									matches,
+									compare<TOP_BELOW>(
+										_mm256_load_si256(base + 1),
+										_mm256_set1_epi16(tops[j])
+									)
+								);
+
+							base += 2;
+						}
+
+						return BasicQuantizedNode::toBitset(matches);
+					}
+
+
+					/**
+					 * Compare offsets without sign.
+					 *
+					 * @tparam BELOW Whether to test for the subjects being at
+					 *         or below the reference (else at or above)
+					 * @return All bits set for each matching offset
+					 */
+					template<bool BELOW>
+					static __m256i compare(__m256i subject, __m256i reference)
+					{
+						const __m256i high = _mm256_max_epu16(subject, reference);
+
+						return _mm256_cmpeq_epi16(
+								high,
+								BELOW ? reference : subject
+							);
+					}
+			};
+
+
+
+
+			BasicQuantizedNode() = default;
+
+
+			/**
+			 * Construct a node with a given set of entries.
+			 *
+			 * Unlike the constructor of BaseNode, this adds the entries once
+			 * the members of this node are initialized.
+			 *
+			 * @tparam E Entry type
+			 * @param entries Entries to add
+			 */
+			template<class E>
+			BasicQuantizedNode(const std::initializer_list<E>& entries)
+			{
+				assign(entries.begin(), entries.end());
+			}
+
+
+			/**
+			 * Scan node and return set of matching entries.
+			 */
+			template<class E>
+			std::pair<ScanIterator, ScanIterator> scan(
+					const Mbr& mbr,
+					const E&,
+					Predicate predicate = Predicate::INTERSECTS
+				) const
+			{
+				return std::make_pair(
+						ScanIterator(this, mbr, 0, predicate),
+						ScanIterator(this, mbr, getSize())
+					);
+			}
+
+
+			/**
+			 * Replace the entries in this node.
+			 *
+			 * The frame is fitted to all the new entries up front, rather than
+			 * grown by each of them.
+			 *
+			 * @param first Iterator to first element of range
+			 * @param last Iterator to past-the-end of the range
+			 */
+			template<class ForwardIterator>
+			void assign(ForwardIterator first, ForwardIterator last)
+			{
+				if (first != last) {
+					Mbr bounds = (*first).getMbr();
+
+					for (ForwardIterator it = first; it != last; ++it) {
+						bounds += (*it).getMbr();
+					}
+
+					setFrame(bounds);
+				}
+
+				fitted = true;
+				Base::assign(first, last);
+				fitted = false;
+			}
+
+
+			/**
+			 * Remove the entry at the given position.
+			 *
+			 * The frame is fitted to the remaining entries once they have
+			 * been moved forward.
+			 *
+			 * @param position Iterator to the entry to remove
+			 */
+			void erase(typename Base::iterator position)
+			{
+				fitted = true;
+				Base::erase(position);
+				fitted = false;
+
+				// Setting an entry fits the frame to all of them
+				if (getSize() > 0) {
+					setMbr(0, getMbr(0));
+				}
+			}
+
+
+			/**
+			 * Override new operator to make sure memory is aligned.
+			 */
+			void * operator new(std::size_t count)
+			{
+				void * p;
+				int error = posix_memalign(&p, sizeof(__m256i), count);
+
+				// Convert C-style error to exception
+				if (error) {
+					throw std::bad_alloc();
+				}
+
+				return p;
+			}
+
+
+			/**
+			 * Override delete operator to use correct delete method.
+			 */
+			void operator delete (void * pointer)
+			{
+				free(pointer);
+			}
+
+
+
+			/**
+			 * Get the plugin of an entry in this node.
+			 *
+			 * @param index Index of entry
+			 * @return Plugin of entry at the given index
+			 */
+			Plugin getPlugin(unsigned index) const
+			{
+				return plugins[index];
+			}
+
+
+			/**
+			 * Get the link of an entry in this node.
+			 *
+			 * @param index Index of entry
+			 * @return Link of entry at the given index
+			 */
+			Link getLink(unsigned index) const
+			{
+				return links[index];
+			}
+
+
+			/**
+			 * Get the MBR of an entry in this node.
+			 *
+			 * Without EXACT, this is the MBR rounded onto the grid, which
+			 * covers the original one.
+			 *
+			 * @param index Index of entry
+			 * @return MBR of entry at the given index
+			 */
+			Mbr getMbr(unsigned index) const
+			{
+				if (EXACT) {
+					return exact[index];
+				}
+
+				return rounded(index);
+			}
+
+
+			/**
+			 * Set the MBR of an entry in this node.
+			 *
+			 * The frame is fitted to the entries including the new MBR,
+			 * unless it has already been fitted to the entries being assigned.
+			 *
+			 * @param index Index of entry for which to set MBR
+			 */
+			void setMbr(unsigned index, const Mbr& m)
+			{
+				if (!fitted) {
+					fit(m, index);
+				}
+
+				store(index, m);
+			}
+
+
+			/**
+			 * Set the link of an entry in this node.
+			 *
+			 * @param index Index of entry for which to set link
+			 */
+			void setLink(unsigned index, const Link& l)
+			{
+				links[index] = l;
+			}
+
+
+			/**
+			 * Set the plugin of an entry in this node.
+			 *
+			 * @param index Index of entry for which to set plugin
+			 */
+			void setPlugin(unsigned index, const Plugin& p)
+			{
+				plugins[index] = p;
+			}
+
+
+		private:
+			__m256i coordinates[N_BLOCKS * 2 * D];
+			Link links[C];
+			PluginArray<Plugin, C> plugins;
+
+			// Grid the offsets are relative to
+			Mbr frame;
+			Coordinate step[D];
+
+			// Whether the frame already spans the entries being assigned
+			bool fitted = false;
+
+			// Original MBRs, only used with EXACT
+			Mbr exact[EXACT ? C : 1];
+
+
+			/**
+			 * Get the coordinate of an offset.
+			 */
+			Coordinate value(unsigned d, long offset) const
+			{
+				return offset == STEPS
+					? frame.getTop()[d]
+					: frame.getBottom()[d] + offset * step[d];
+			}
+
+
+			/**
+			 * Get the highest offset at or below a coordinate.
+			 *
+			 * @return Offset, -1 if below the frame
+			 */
+			long floor(unsigned d, Coordinate x) const
+			{
+				if (x < frame.getBottom()[d]) {
+					return -1;
+				}
+
+				if (x >= frame.getTop()[d]) {
+					return STEPS;
+				}
+
+				long offset = std::min(
+						static_cast<long>((x - frame.getBottom()[d]) / step[d]),
+						STEPS - 1
+					);
+
+				// Correct for rounding errors
+				while (offset < STEPS && value(d, offset + 1) <= x) {
+					++offset;
+				}
+
+				while (offset > 0 && value(d, offset) > x) {
+					--offset;
+				}
+
+				return offset;
+			}
+
+
+			/**
+			 * Get the lowest offset at or above a coordinate.
+			 *
+			 * @return Offset, STEPS + 1 if above the frame
+			 */
+			long ceil(unsigned d, Coordinate x) const
+			{
+				if (x <= frame.getBottom()[d]) {
+					return 0;
+				}
+
+				if (x > frame.getTop()[d]) {
+					return STEPS + 1;
+				}
+
+				long offset = std::max(
+						static_cast<long>(
+							std::ceil((x - frame.getBottom()[d]) / step[d])
+						),
+						1l
+					);
+				offset = offset > STEPS ? STEPS : offset;
+
+				// Correct for rounding errors
+				while (offset > 0 && value(d, offset - 1) >= x) {
+					--offset;
+				}
+
+				while (offset < STEPS && value(d, offset) < x) {
+					++offset;
+				}
+
+				return offset;
+			}
+
+
+			/**
+			 * Set the frame and the size of its steps.
+			 */
+			void setFrame(const Mbr& m)
+			{
+				frame = m;
+
+				for (unsigned d = 0; d < D; ++d) {
+					step[d] = (m.getTop()[d] - m.getBottom()[d]) / STEPS;
+				}
+			}
+
+
+			/**
+			 * Fit the frame to the entries, rounding them onto the new grid if
+			 * it changes.
+			 *
+			 * @param m MBR of the entry about to be set
+			 * @param skip Index of the entry about to be set
+			 */
+			void fit(const Mbr& m, unsigned skip)
+			{
+				Mbr bounds = m;
+
+				for (unsigned i = 0; i < getSize(); ++i) {
+					if (i != skip) {
+						bounds += getMbr(i);
+					}
+				}
+
+				if (bounds != frame) {
+					reframe(bounds, skip);
+				}
+			}
+
+
+			/**
+			 * Change the frame and round all other entries onto the new grid.
+			 *
+			 * @param m New frame
+			 * @param skip Index of the entry about to be set
+			 */
+			void reframe(const Mbr& m, unsigned skip)
+			{
+				Mbr previous[C];
+
+				for (unsigned i = 0; i < getSize(); ++i) {
+					if (i != skip) {
+						previous[i] = getMbr(i);
+					}
+				}
+
+				setFrame(m);
+
+				for (unsigned i = 0; i < getSize(); ++i) {
+					if (i != skip) {
+						store(i, previous[i]);
+					}
+				}
+			}
+
+
+			/**
+			 * Round an MBR onto the grid and store it.
+			 */
+			void store(unsigned index, const Mbr& m)
+			{
+				Offset * base = reinterpret_cast<Offset *>(
+						coordinates + 2 * D * (index / BLOCK_SIZE)
+					) + index % BLOCK_SIZE;
+
+				for (unsigned d = 0; d < D; ++d) {
+					base[0] = floor(d, m.getBottom()[d]);
+					base[BLOCK_SIZE] = ceil(d, m.getTop()[d]);
+					base += 2 * BLOCK_SIZE;
+				}
+
+				if (EXACT) {
+					exact[index] = m;
+				}
+			}
+
+
+			/**
+			 * Get the MBR of an entry as rounded onto the grid.
+			 */
+			Mbr rounded(unsigned index) const
+			{
+				std::array<Coordinate, D> bottom, top;
+
+				const Offset * base = reinterpret_cast<const Offset *>(
+						coordinates + 2 * D * (index / BLOCK_SIZE)
+					) + index % BLOCK_SIZE;
+
+				for (unsigned d = 0; d < D; ++d) {
+					bottom[d] = value(d, base[0]);
+					top[d] = value(d, base[BLOCK_SIZE]);
+					base += 2 * BLOCK_SIZE;
+				}
+
+				return Mbr(top, bottom);
+			}
+
+
+			/**
+			 * Turn the result of comparing a block into a bitset.
+			 *
+			 * @param matches All bits set for each matching offset
+			 * @return Bitset with a bit for each entry of the block
+			 */
+			static unsigned toBitset(__m256i matches)
+			{
+				// Narrow to bytes, which keeps each half of the block in
+				// its own 128 bit lane
+				const unsigned mask = _mm256_movemask_epi8(
+						_mm256_packs_epi16(matches, matches)
+					);
+
+				return (mask & 0xff) | ((mask >> 8) & 0xff00);
+			}
+	};
+
+
+	/**
+	 * Quantized node, matching entries just outside queries too.
+	 */
+	template<unsigned D, unsigned C, class P = EntryPlugin>
+	using QuantizedNode = BasicQuantizedNode<D, C, P, false>;
+
+
+	/**
+	 * Quantized node, checking matches against the original MBRs.
+	 */
+	template<unsigned D, unsigned C, class P = EntryPlugin>
+	using ExactQuantizedNode = BasicQuantizedNode<D, C, P, true>;
+
+}
@@ -0,0 +1,182 @@
+#include "Node.test.hpp"
+#include "QuantizedNode.hpp"
+#include "QuadraticRtree.hpp"
+
+// The generic tests expect exact results, which only ExactQuantizedNode gives
+
+Test(QuantizedNode, data_retainment)
+{
+	testRetainment<ExactQuantizedNode>();
+}
+
+
+Test(QuantizedNode, scan)
+{
+	testScanning<ExactQuantizedNode>();
+}
+
+
+Test(QuantizedNode, scan_batch)
+{
+	testBatchScanning<ExactQuantizedNode>();
+}
+
+
+Test(QuantizedNode, scan_predicates)
+{
+	testPredicateScanning<ExactQuantizedNode>();
+}
+
+
+Test(QuantizedNode, scan_distance)
+{
+	testDistanceScanning<ExactQuantizedNode>();
+}
+
+
+Test(QuantizedNode, rounding)
+{
+	using N = QuantizedNode<2, 8, EntryPlugin>;
+	using X = ExactQuantizedNode<2, 8, EntryPlugin>;
+
+	// Far from the steps of the grid spanned by the first two entries
+	std::vector<Mbr<2>> mbrs {
+			Box(Point {0.0, 0.0}, Point {1.0, 1.0}),
+			Box(Point {1e5, 1e5}, Point {1e5 + 1.0, 1e5 + 1.0}),
+			Box(Point {0.1, 0.7}, Point {0.3, 0.9}),
+		};
+
+	N node;
+	X exact;
+
+	for (unsigned i = 0; i < mbrs.size(); ++i) {
+		node.add(Entry<N>(mbrs[i], i, EntryPlugin()));
+		exact.add(Entry<X>(mbrs[i], i, EntryPlugin()));
+	}
+
+	for (unsigned i = 0; i < mbrs.size(); ++i) {
+		cr_expect(
+				node.getMbr(i).contains(mbrs[i]),
+				"Stored MBR should cover the original"
+			);
+		cr_expect_eq(
+				exact.getMbr(i),
+				mbrs[i],
+				"Exact node should keep the original MBR"
+			);
+	}
+
+	// An entry outside the grid moves the others onto a coarser one
+	Mbr<2> far = Box(Point {-1e6, -1e6}, Point {-1e6 + 1.0, -1e6 + 1.0});
+	node.add(Entry<N>(far, 3, EntryPlugin()));
+	exact.add(Entry<X>(far, 3, EntryPlugin()));
+	mbrs.push_back(far);
+
+	for (unsigned i = 0; i < mbrs.size(); ++i) {
+		cr_expect(
+				node.getMbr(i).contains(mbrs[i]),
+				"Growing the grid should keep stored MBRs covering the originals"
+			);
+	}
+
+	// Touching the third entry from each side, and just missing it
+	const double gap = 1e-3;
+	std::vector<std::pair<Mbr<2>, bool>> queries {
+			{Box(Point {0.3, 0.9}, Point {0.4, 1.0}), true},
+			{Box(Point {0.05, 0.6}, Point {0.1, 0.7}), true},
+			{Box(Point {0.2, 0.8}, Point {0.2, 0.8}), true},
+			{Box(Point {0.3 + gap, 0.8}, Point {0.4, 0.85}), false},
+			{Box(Point {0.0, 0.2}, Point {0.05, 0.7 - gap}), false},
+		};
+
+	for (const auto& query : queries) {
+		auto range = node.scan(query.first, Entry<N>(&node));
+		auto exactRange = exact.scan(query.first, Entry<X>(&exact));
+
+
+		bool found = false;
+		for (auto it = range.first; it != range.second; ++it) {
+			found = found || (*it).getLink().getId() == 2;
+		}
+
+		if (query.second) {
+			cr_expect(found, "Rounding should never lose a match");
+		}
+
+		found = false;
+		for (auto it = exactRange.first; it != exactRange.second; ++it) {
+			found = found || (*it).getLink().getId() == 2;
+		}
+
+		cr_expect_eq(
+				found,
+				query.second,
+				"Exact node should match as with double precision"
+			);
+	}
+
+	// Within a box ending exactly at the third entry
+	auto within = node.scan(
+			Mbr<2>(Box(Point {0.1, 0.7}, Point {0.3, 0.9})),
+			Entry<N>(&node),
+			Predicate::WITHIN
+		);
+
+	cr_expect(
+			within.first != within.second,
+			"Rounding should never lose a match within a query"
+		);
+
+	// Queries outside the grid match nothing
+	auto outside = node.scan(
+			Mbr<2>(Box(Point {2e5, 0.0}, Point {3e5, 1.0})),
+			Entry<N>(&node)
+		);
+
+	cr_expect(
+			outside.first == outside.second,
+			"Queries outside the grid should not match anything"
+		);
+}
+
+
+Test(QuantizedNode, tree_structure)
+{
+	using Tree = QuadraticRtree<QuantizedNode<2, 16, EntryPlugin>, 6>;
+
+	// Boxes of varying size, off the steps of any grid
+	std::vector<DataObject> objects;
+
+	for (unsigned i = 0; i < 5000; ++i) {
+		double x = (i * 7919u % 10007u) / 7.0;
+		double y = (i * 104729u % 10009u) / 11.0;
+		double size = 0.1 + (i % 13) / 7.0;
+
+		objects.emplace_back(
+				i + 1,
+				Box(Point {x, y}, Point {x + size, y + size / 3.0})
+			);
+	}
+
+	Tree inserted, loaded;
+
+	for (const DataObject& object : objects) {
+		inserted.insert(object);
+	}
+
+	loaded.bulkLoad(objects);
+
+	for (Tree * tree : {&inserted, &loaded}) {
+		try {
+			tree->checkStructure();
+
+			for (unsigned i = 0; i < objects.size(); i += 2) {
+				tree->remove(objects[i]);
+			}
+
+			tree->checkStructure();
+		} catch (const InvalidStructureError& e) {
+			cr_assert_fail("Invalid structure of quantized tree: %s", e.what());
+		}
+	}
+}
@@ -60,6 +60,22 @@ class RStarTree : public Rtree<Node, m>
 		};
 
 
+	protected:
+		using Base::createNode;
+
+
+		/**
+		 * Create a leaf entry with a default initialized plugin.
+		 *
+		 * @param object Data object to create entry for
+		 * @return New entry for object
+		 */
+		Entry<N> createEntry(const DataObject& object) const override
+		{
+			return Entry<N>(object);
+		};
+
+
 	private:
 
 		/**
@@ -82,7 +98,7 @@ class RStarTree : public Rtree<Node, m>
 			// Single entry - add new root
 			if (height - level == 1) {
 				addLevel(
-						Entry<N>(new N({getRoot(), entry}))
+						Entry<N>(createNode({getRoot(), entry}))
 					);
 				return;
 			}
@@ -150,7 +166,7 @@ class RStarTree : public Rtree<Node, m>
 			if (node.isFull()) {
 				entry = split(getRoot(), entry);
 				addLevel(
-						Entry<N>(new N({getRoot(), entry}))
+						Entry<N>(createNode({getRoot(), entry}))
 					);
 				return;
 			}
@@ -174,7 +190,7 @@ class RStarTree : public Rtree<Node, m>
 		Entry<N> split(E& parent, Entry<N> entry)
 		{
 			// Create new node
-			Entry<N> newEntry (new N {entry});
+			Entry<N> newEntry (createNode({entry}));
 
 			// Distribute children
 			redistribute(
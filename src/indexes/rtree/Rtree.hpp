@@ -1,12 +1,29 @@
 #pragma once
 #include "spatial/SpatialIndex.hpp"
 #include "spatial/InvalidStructureError.hpp"
+#include "spatial/Arena.hpp"
 #include "KnnQueueEntry.hpp"
+#include "AggregateEntryPlugin.hpp"
 #include "Mbr.hpp"
 #include "Entry.hpp"
+#include "ProxyEntry.hpp"
+#include "SharedPairSink.hpp"
+#include "ScratchFrames.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
+#ifdef _OPENMP
+#	include <omp.h>
+#endif
+
 
 namespace Rtree
 {
@@ -35,6 +52,33 @@ class Rtree : public ::SpatialIndex
 		using M = typename N::Mbr;
 		using Id = DataObject::Id;
 
+		/**
+		 * Maximum height of the tree.
+		 *
+		 * Searches keep their traversal stack on the call stack, sized by
+		 * this. Nodes have at least two children on average, so no tree
+		 * fitting in memory comes close.
+		 */
+		static constexpr unsigned MAX_HEIGHT = 32;
+
+		/**
+		 * Number of queries sent down the tree together by `searchBatch`.
+		 */
+		static constexpr unsigned BATCH_SIZE = 64;
+
+		/**
+		 * Pairs of subtrees higher than this (summed) are joined in separate
+		 * tasks by the parallel join, thus each pair of nodes above the
+		 * leaves gets its own task.
+		 */
+		static constexpr unsigned JOIN_TASK_HEIGHT = 4;
+
+		/**
+		 * Number of pairs of leaves (or lower) joined by each task in the
+		 * parallel join.
+		 */
+		static constexpr unsigned JOIN_CHUNK = 16;
+
 		/**
 		 * Construct a new index from the given data set.
 		 */
@@ -42,7 +86,7 @@ class Rtree : public ::SpatialIndex
 
 
 		/**
-		 * Walks the tree and deletes all nodes.
+		 * Deletes all nodes, walking the tree only if they need destruction.
 		 */
 		virtual ~Rtree();
 
@@ -55,6 +99,134 @@ class Rtree : public ::SpatialIndex
 		virtual void insert(const DataObject& object) = 0;
 
 
+		/**
+		 * Build the tree bottom-up from a complete data set.
+		 *
+		 * The tree must be empty. Each level is packed into nodes filled to
+		 * the fill factor (see `pack`) until a single root entry remains.
+		 *
+		 * When compiled with OpenMP, the data set is first split into one
+		 * partition per thread (see `partition`). The lower levels of each
+		 * partition are packed in parallel, and the remaining upper levels
+		 * are packed on top of all partitions.
+		 *
+		 * @param objects Data objects to index
+		 */
+		void bulkLoad(const std::vector<DataObject>& objects) override;
+
+
+		/**
+		 * Remove a data object from the tree.
+		 *
+		 * The leaf holding the object is found by its box and id. Nodes on
+		 * the path from that leaf are then condensed bottom-up (see
+		 * `condense`), before the root is shortened while it only has a
+		 * single child.
+		 *
+		 * @param object Data object to remove
+		 * @return True if the object was found and removed
+		 */
+		bool remove(const DataObject& object) override;
+
+
+		/**
+		 * Move a data object to a new box.
+		 *
+		 * The object is found using its old box, and then moved bottom-up:
+		 * It is patched in place if it still fits in its leaf or the leaf
+		 * may grow within its parent. Otherwise, it is moved to a sibling
+		 * leaf covering the new box (see `relocate`). Only if that fails is
+		 * it removed and inserted again.
+		 *
+		 * @param id Id of the object to move
+		 * @param oldBox Current box of the object
+		 * @param newBox New box of the object
+		 * @return True if the object was found and updated
+		 */
+		bool update(Id id, const Box& oldBox, const Box& newBox) override;
+
+
+		/**
+		 * Run a batch of range searches in a single traversal.
+		 *
+		 * The queries are ordered along a Z-order curve and split into
+		 * groups of BATCH_SIZE, such that nearby queries are grouped. Each
+		 * node is then visited once per group, for the queries intersecting
+		 * it (kept as a bit mask). Nodes able to test several queries at once
+		 * do so (see `scanBatch`). Each query gets its results in the same
+		 * order as from a single search.
+		 *
+		 * @param queries Range queries to run
+		 * @param sinks Sink receiving the results, one for each query
+		 */
+		void searchBatch(
+				const std::vector<RangeQuery>& queries,
+				const std::vector<ResultSink *>& sinks
+			) const override;
+
+
+		/**
+		 * Count the objects intersecting a box.
+		 *
+		 * With a plugin keeping subtree counts (see `AggregateEntryPlugin`),
+		 * the search does not descend into entries inside the box, but adds
+		 * their counts. Otherwise, the objects found are counted.
+		 *
+		 * @param box Box to count objects in
+		 * @return Number of objects intersecting box
+		 */
+		unsigned long long count(const Box& box) const override;
+
+
+		/**
+		 * Sum the payload of the objects intersecting a box.
+		 *
+		 * Like `count`, but requires a plugin keeping sums of a payload.
+		 *
+		 * @param box Box to sum objects in
+		 * @return Sum of the payload of objects intersecting box
+		 */
+		template<class P = typename N::Plugin>
+		typename P::Value sum(const Box& box) const;
+
+
+		/**
+		 * Set the fill factor used when bulk loading.
+		 *
+		 * Nodes are never filled with less than `m` entries, regardless of
+		 * the fill factor.
+		 *
+		 * @param fill Fraction of node capacity to fill, in (0, 1]
+		 */
+		void setFillFactor(double fill);
+
+
+		/**
+		 * Set the pages backing the nodes allocated from now on.
+		 *
+		 * Huge pages map the nodes with far fewer TLB entries, which pays off
+		 * once the tree outgrows the reach of the TLB.
+		 *
+		 * @param pages Kind of pages
+		 */
+		void setPages(Pages pages);
+
+
+		/**
+		 * Set how far the searches prefetch the nodes they descend into.
+		 *
+		 * While scanning a node above the leaves, the nodes of the next few
+		 * matching entries are prefetched, such that the misses on them
+		 * overlap with the search of the subtrees before them.
+		 *
+		 * @param distance Number of matching entries prefetched ahead of the
+		 *        one descended into, 0 to disable prefetching
+		 * @param lines Number of cache lines prefetched from the start of
+		 *        each node (at most the size of a node)
+		 */
+		void setPrefetch(unsigned distance, unsigned lines);
+
+
 		/**
 		 * Get the tree height.
 		 *
@@ -82,7 +254,8 @@ class Rtree : public ::SpatialIndex
 		 *
 		 * Currently checks the following:
 		 *  - All MBRs are contained within their parents MBR,
-		 *  - MBRs are as tight as possible and
+		 *  - MBRs are as tight as possible (if the nodes keep MBRs as they
+		 *    are set, see `BaseNode::tight`) and
 		 *  - the upper and lower number of children is respected
 		 */
 		void checkStructure() const override;
@@ -99,10 +272,219 @@ class Rtree : public ::SpatialIndex
 		StatsCollector collectStatistics() const override;
 
 
+		/**
+		 * Collects statistics of the arena holding the nodes.
+		 *
+		 * @return Statistics collected
+		 */
+		StatsCollector collectMemoryStatistics() const override;
+
+
 
 
 	protected:
 
+		/**
+		 * Breadth-first predicate search.
+		 *
+		 * Scans the tree one level at a time, keeping the matching nodes of
+		 * the level below in a frontier. The frontier is visited in the
+		 * order of the node addresses, and prefetched as set by
+		 * `setPrefetch`, which turns the pointer chasing of large queries
+		 * into a stream through memory. Depth-first searches, on the other
+		 * hand, keep a single path and stop early once the sink asks for it.
+		 *
+		 * @param sink Sink for the matching objects
+		 * @param box Query box
+		 * @param predicate Predicate the objects must fulfil
+		 * @see BreadthFirstRtree
+		 */
+		void levelSearch(
+				ResultSink& sink,
+				const Box& box,
+				Predicate predicate
+			) const;
+
+
+		/**
+		 * Create a leaf entry for a data object.
+		 *
+		 * This allows subclasses to initialize the entry plugin the same way
+		 * as during insertion.
+		 *
+		 * @param object Data object to create entry for
+		 * @return New entry with the object's MBR and id
+		 */
+		virtual Entry<N> createEntry(const DataObject& object) const = 0;
+
+
+		/**
+		 * Create a node in the arena of this tree.
+		 *
+		 * @param entries Initial entries of the node
+		 * @return New node
+		 */
+		N * createNode(std::initializer_list<Entry<N>> entries) const;
+
+
+		/**
+		 * Delete a node created by `createNode`.
+		 *
+		 * @param node Node to delete
+		 */
+		void destroyNode(N * node) const;
+
+
+		/**
+		 * Pack a level of entries into new nodes during bulk loading.
+		 *
+		 * Uses Sort-Tile-Recursive: The entries are sorted by center along the
+		 * first dimension and cut into slabs, which are recursively tiled
+		 * along the remaining dimensions.
+		 *
+		 * @param entries Entries to pack (may be reordered)
+		 * @param parents Destination for the entries of the new nodes
+		 */
+		virtual void pack(
+				std::vector<Entry<N>>& entries,
+				std::vector<Entry<N>>& parents
+			);
+
+
+		/**
+		 * Split a range of entries in two during parallel bulk loading.
+		 *
+		 * Rearranges the range such that the entries in [first, middle) are
+		 * before the entries in [middle, last) in the packing order. The
+		 * default splits along dimension `depth % D` by center, giving the
+		 * same slabs as Sort-Tile-Recursive.
+		 *
+		 * @param first Iterator to first entry
+		 * @param middle Where to split the range
+		 * @param last Past-the-end iterator
+		 * @param depth Number of splits above this one
+		 */
+		virtual void split(
+				typename std::vector<Entry<N>>::iterator first,
+				typename std::vector<Entry<N>>::iterator middle,
+				typename std::vector<Entry<N>>::iterator last,
+				unsigned depth
+			) const;
+
+
+		/**
+		 * Calculate the number of nodes needed to pack a number of entries.
+		 *
+		 * Respects the fill factor, but never leaves less than `m` entries in
+		 * any node.
+		 *
+		 * @param entries Number of entries to pack
+		 * @return Number of nodes
+		 */
+		std::size_t nodeCount(std::size_t entries) const;
+
+
+		/**
+		 * Distribute a range of entries evenly over a number of new nodes.
+		 *
+		 * The order of the entries is kept, such that the first entries end
+		 * up in the first node.
+		 *
+		 * @param first Iterator to first entry
+		 * @param last Past-the-end iterator
+		 * @param nodes Number of nodes to create
+		 * @param parents Destination for the entries of the new nodes
+		 */
+		template<class RandomIt>
+		void distribute(
+				RandomIt first,
+				RandomIt last,
+				std::size_t nodes,
+				std::vector<Entry<N>>& parents
+			) const;
+
+
+		/**
+		 * Find the path from the root node to the entry of a data object.
+		 *
+		 * Only subtrees containing the object's box are searched.
+		 *
+		 * @param object Data object to find
+		 * @return Iterators to the entry followed at each level below the
+		 *         root, ending with the object's entry, or empty if not found
+		 */
+		std::vector<typename N::iterator> findPath(const DataObject& object);
+
+
+		/**
+		 * Condense the tree after an entry has been removed from a node.
+		 *
+		 * Walks up the path and handles underflowing nodes as in Guttman's
+		 * CondenseTree: Nodes with less than `m` entries are removed and
+		 * their data objects are collected for reinsertion. The MBRs of the
+		 * remaining nodes on the path are tightened.
+		 *
+		 * @param path Iterators to the entries of the nodes below the root
+		 *        which lost an entry, the deepest last
+		 * @param orphans Destination for data entries to reinsert
+		 */
+		virtual void condense(
+				std::vector<typename N::iterator>& path,
+				std::vector<Entry<N>>& orphans
+			);
+
+
+		/**
+		 * Try to replace a data entry without reinsertion.
+		 *
+		 * The entry is patched in place if possible (see `patch`). Otherwise
+		 * it is moved to a sibling leaf which covers it and has room, as long
+		 * as the leaf does not underflow. The MBRs on the path are tightened.
+		 *
+		 * @param path Path to the data entry (see `findPath`)
+		 * @param entry New entry for the data object
+		 * @return True if the entry was replaced
+		 */
+		virtual bool relocate(
+				std::vector<typename N::iterator>& path,
+				const Entry<N>& entry
+			);
+
+
+		/**
+		 * Replace a data entry in place, if it only grows the tree locally.
+		 *
+		 * This is the case if the leaf covers the new entry, or if the leaf
+		 * can grow without growing its parent.
+		 *
+		 * @param path Path to the data entry (see `findPath`)
+		 * @param entry New entry for the data object
+		 * @return True if the entry was replaced
+		 */
+		bool patch(
+				std::vector<typename N::iterator>& path,
+				const Entry<N>& entry
+			);
+
+
+		/**
+		 * Recalculate the entries above a data entry, bottom-up.
+		 *
+		 * @param path Path to the data entry (see `findPath`)
+		 */
+		void tighten(std::vector<typename N::iterator>& path);
+
+
+		/**
+		 * Collect the data entries of a subtree and delete its nodes.
+		 *
+		 * @param node Root node of subtree
+		 * @param height Height of the subtree, as for `deleteTree`
+		 * @param entries Destination for the data entries
+		 */
+		void release(N& node, unsigned height, std::vector<Entry<N>>& entries);
+
+
 		/**
 		 * Traverses the entire tree and executes the visitor for each entry.
 		 *
@@ -119,8 +501,66 @@ class Rtree : public ::SpatialIndex
 
 		/**
 		 * Range search with Guttman's algorithm.
+		 *
+		 * The tree is not modified, thus any number of threads may search
+		 * concurrently (as long as no thread modifies the tree). The search
+		 * stops as soon as the sink asks for it.
+		 */
+		void rangeSearch(ResultSink& sink, const Box& box) const override;
+
+
+		/**
+		 * Search for the objects related to a box by a predicate.
+		 *
+		 * Like range search, but the entries of the leaves are scanned for
+		 * the predicate. Above the leaves, entries are scanned for the
+		 * predicate their subtree must fulfil to hold a matching object:
+		 * Objects can only contain the query below entries containing it,
+		 * and only be within it below entries intersecting it.
+		 */
+		void predicateSearch(
+				ResultSink& sink,
+				const Box& box,
+				Predicate predicate
+			) const override;
+
+
+		/**
+		 * Search for the objects within a distance of a box.
+		 *
+		 * Like range search, but each node is scanned for the distance of
+		 * its entries at once (see `scanDistance` of the nodes), and only
+		 * entries within the radius are descended.
+		 */
+		void radiusSearch(
+				ResultSink& sink,
+				const Box& box,
+				double radius
+			) const override;
+
+
+		/**
+		 * Spatial join by synchronized traversal (Brinkhoff, Kriegel and
+		 * Seeger).
+		 *
+		 * Only joins with R-trees of the same type. Both trees are descended
+		 * together from the roots. For each pair of entries within the
+		 * distance of each other, only the children within the distance of
+		 * the other entry are scanned, and the children of both are then
+		 * paired by a plane sweep along the first dimension (see
+		 * `joinEntries`). When the trees differ in height, only the higher
+		 * one is descended until the levels line up. Like range search, this
+		 * is safe to run concurrently.
+		 *
+		 * When compiled with OpenMP and several threads are available, the
+		 * pairs of entries are joined in parallel tasks (see `joinTasks`),
+		 * and the pairs come out in no particular order.
 		 */
-		void rangeSearch(Results& results, const Box& box) const override;
+		void distanceJoin(
+				PairSink& sink,
+				const SpatialIndex& other,
+				double distance
+			) const override;
 
 
 		/**
@@ -130,236 +570,1975 @@ class Rtree : public ::SpatialIndex
 
 
 		/**
-		 * k-NN search is currently not implemented, but throws when called.
+		 * Predicate search - with instrumentation.
+		 *
+		 * Counts the nodes and leaves visited by the predicate search, along
+		 * with the results.
+		 */
+		void predicateSearch(
+				StatsCollector& stats,
+				const Box& box,
+				Predicate predicate
+			) const override;
+
+
+		/**
+		 * Radius search - with instrumentation.
+		 *
+		 * Counts the nodes and leaves visited by the radius search, along
+		 * with the results.
+		 */
+		void radiusSearch(
+				StatsCollector& stats,
+				const Box& box,
+				double radius
+			) const override;
+
+
+		/**
+		 * Best-first k-NN search (Hjaltason and Samet).
+		 *
+		 * Entries are visited in order of their minimum distance to the
+		 * point, so objects come out of the queue nearest first. Ties are
+		 * broken by id. Like range search, this is safe to run concurrently.
+		 */
+		void knnSearch(
+				Results& results,
+				unsigned k,
+				const Point& point
+			) const override;
+
+
+		/**
+		 * Best-first k-NN search - with instrumentation.
 		 */
-		void knnSearch(Results&, unsigned, const Point&) const override;
+		void knnSearch(
+				StatsCollector& stats,
+				unsigned k,
+				const Point& point
+			) const override;
 
 	private:
 
 		unsigned height;
 		Entry<N> root;
+		double fill = 1.0;
+
+		// Nodes are kept together, on huge pages if possible
+		mutable Arena arena {sizeof(N), alignof(N)};
+
+		unsigned prefetchDistance = 0;
+		unsigned prefetchLines = 1;
 
-		// "Stack" used during search
-		std::pair<NIt, NIt> * path;
 
 		/**
-		 * Deletes the nodes in this tree.
+		 * Prefetch the start of a node.
 		 *
-		 * Traverse the tree and delete all nodes on the way.
+		 * @param node Node to prefetch
+		 */
+		void prefetch(const N& node) const;
+
+
+		/**
+		 * Depth-first predicate search prefetching the nodes ahead of the
+		 * descent into them, for trees of at least two levels.
 		 *
-		 * @param root Root node of tree to delete
-		 * @param height Height of given tree
+		 * @param sink Sink for the matching objects
+		 * @param query Query box
+		 * @param predicate Predicate the objects must fulfil
 		 */
-		void deleteTree(N& root, unsigned height);
-};
+		void prefetchSearch(
+				ResultSink& sink,
+				const M& query,
+				Predicate predicate
+			) const;
 
-/*
- ___                 _                           _        _   _             
-|_ _|_ __ ___  _ __ | | ___ _ __ ___   ___ _ __ | |_ __ _| |_(_) ___  _ __  
- | || '_ ` _ \| '_ \| |/ _ \ '_ ` _ \ / _ \ '_ \| __/ _` | __| |/ _ \| '_ \ 
- | || | | | | | |_) | |  __/ | | | | |  __/ | | | || (_| | |_| | (_) | | | |
-|___|_| |_| |_| .__/|_|\___|_| |_| |_|\___|_| |_|\__\__,_|\__|_|\___/|_| |_|
-              |_|                                                           
-*/
-template <class N, unsigned m>
-Rtree<N, m>::Rtree() : height(0), path(nullptr)
-{
-};
 
-template <class N, unsigned m>
-Rtree<N, m>::~Rtree()
-{
-	deleteTree(getRoot().getNode(), getHeight());
-	if (path) {
-		delete[] path;
-	}
+		/**
+		 * Best-first k-NN search, optionally counting visited nodes.
+		 *
+		 * Besides the queue, the distances of the k nearest objects queued
+		 * so far are kept in a bounded max-heap. Entries farther away than
+		 * the k-th of these can never be part of the result and are thus
+		 * never queued.
+		 *
+		 * @param results Destination for the nearest objects, nearest first
+		 * @param k Number of objects to find
+		 * @param point Query point
+		 * @param stats Statistics to update, or null
+		 */
+		void nearest(
+				Results& results,
+				unsigned k,
+				const Point& point,
+				StatsCollector * stats
+			) const;
+
+
+		/**
+		 * Join the subtrees of two entries within the distance of each other.
+		 *
+		 * The children of the entry with the greatest height (or of both,
+		 * if equally high) within the distance of the other entry are
+		 * collected, and sorted along the first dimension. A plane sweep
+		 * over the two lists then joins each pair of entries within the
+		 * distance.
+		 *
+		 * @param sink Sink receiving the pairs
+		 * @param left Entry in this tree
+		 * @param leftHeight Height of the subtree of left, 1 for data
+		 * @param right Entry in the other tree
+		 * @param rightHeight Height of the subtree of right, 1 for data
+		 * @param distance Largest distance between joined objects
+		 * @param buffers Lists of candidate entries, two for each level of
+		 *        recursion, to avoid allocating for every pair of nodes
+		 * @return False if the sink asked the join to stop
+		 */
+		static bool joinEntries(
+				PairSink& sink,
+				const Entry<N>& left,
+				unsigned leftHeight,
+				const Entry<N>& right,
+				unsigned rightHeight,
+				double distance,
+				std::vector<Entry<N>> * buffers
+			);
+
+
+		/**
+		 * Find the pairs of children of two entries within a distance.
+		 *
+		 * Only the entry with the greatest height (or both, if equally high)
+		 * is descended. Its children intersecting the other entry grown by
+		 * the distance are collected and sorted along the first dimension,
+		 * and a plane sweep then pairs the entries of the two lists within
+		 * the distance of each other. With a distance of 0, these are the
+		 * intersecting entries.
+		 *
+		 * @param left Entry in this tree
+		 * @param leftHeight Height of the subtree of left, above 1
+		 * @param right Entry in the other tree
+		 * @param rightHeight Height of the subtree of right, above 1
+		 * @param distance Largest distance between paired entries
+		 * @param lefts Destination for the candidates from the left
+		 * @param rights Destination for the candidates from the right
+		 * @param visitor Function taking each pair of entries along with
+		 *        their heights, returning false to stop
+		 * @return False if the visitor asked to stop
+		 */
+		template<class F>
+		static bool sweep(
+				const Entry<N>& left,
+				unsigned leftHeight,
+				const Entry<N>& right,
+				unsigned rightHeight,
+				double distance,
+				std::vector<Entry<N>>& lefts,
+				std::vector<Entry<N>>& rights,
+				F visitor
+			);
+
+#		ifdef _OPENMP
+		/**
+		 * Shared state of a parallel join.
+		 */
+		struct JoinState
+		{
+			/** Pair buffer of each thread */
+			std::vector<std::unique_ptr<SharedPairSink>> sinks;
+
+			/** Lists of candidate entries of each thread (see `joinEntries`) */
+			std::vector<std::vector<std::vector<Entry<N>>>> buffers;
+
+			/** Largest distance between joined objects */
+			double distance;
+
+			/** Set once the sink has asked the join to stop */
+			std::atomic<bool> stopped;
+		};
+
+
+		/**
+		 * Join the subtrees of two intersecting entries in parallel tasks.
+		 *
+		 * The pairs of children are found as by `joinEntries`. Each pair
+		 * higher than JOIN_TASK_HEIGHT is joined in a new task, splitting
+		 * it further. The lower pairs are joined in tasks of JOIN_CHUNK pairs
+		 * each, into the pair buffer of the thread running the task. Work is
+		 * thus split where the intersecting pairs are, such that dense
+		 * regions are split into many tasks, which idle threads take.
+		 *
+		 * @param left Entry in this tree
+		 * @param leftHeight Height of the subtree of left, 1 for data
+		 * @param right Entry in the other tree
+		 * @param rightHeight Height of the subtree of right, 1 for data
+		 * @param state Shared state of the join
+		 */
+		static void joinTasks(
+				const Entry<N>& left,
+				unsigned leftHeight,
+				const Entry<N>& right,
+				unsigned rightHeight,
+				JoinState * state
+			);
+#		endif
+
+
+		/**
+		 * Count objects using the subtree counts of the plugin.
+		 */
+		unsigned long long count(const Box& box, std::true_type) const;
+
+
+		/**
+		 * Count objects by a range search.
+		 */
+		unsigned long long count(const Box& box, std::false_type) const;
+
+
+		/**
+		 * Visit the topmost entries covering the objects intersecting a box.
+		 *
+		 * These are the entries inside the box, as their subtrees need not
+		 * be searched, as well as the data entries intersecting the box
+		 * found below the other entries.
+		 *
+		 * @param box Box to search
+		 * @param visitor Function taking the plugin of each entry
+		 */
+		template<class F>
+		void aggregate(const Box& box, F visitor) const;
+
+
+		/**
+		 * Z-order (Morton) code of the center of a box, to order queries.
+		 *
+		 * Much cheaper to compute than a Hilbert value, while still keeping
+		 * nearby queries close.
+		 *
+		 * @param box Box to map
+		 * @param bounds Area covered by the curve, the center is clamped
+		 *               to it
+		 * @return Z-order code
+		 */
+		static std::uint64_t zOrder(const Box& box, const Box& bounds);
+
+
+		/**
+		 * Run a group of at most BATCH_SIZE range searches.
+		 *
+		 * @param queries MBRs of the queries
+		 * @param sinks Sink for each query
+		 * @param n Number of queries
+		 */
+		void searchGroup(
+				const M * queries,
+				ResultSink * const * sinks,
+				unsigned n
+			) const;
+
+
+		/**
+		 * Replace the root and set the height of the tree.
+		 *
+		 * @param newRoot Entry to use as root
+		 * @param newHeight Height of the tree below (and including) newRoot
+		 */
+		void setRoot(const Entry<N>& newRoot, unsigned newHeight);
+
+
+		/**
+		 * Remove the data entry at the end of a path.
+		 *
+		 * @param path Path to the data entry (see `findPath`)
+		 */
+		void erase(std::vector<typename N::iterator>& path);
+
+
+		/**
+		 * Recursively split a range of entries into consecutive partitions.
+		 *
+		 * Each half is split further in a separate task.
+		 *
+		 * @param first Iterator to first entry
+		 * @param last Past-the-end iterator
+		 * @param parts Number of partitions to split the range into
+		 * @param depth Number of splits above this one
+		 * @param partitions Destination for the partitions, one per part
+		 */
+		void partition(
+				typename std::vector<Entry<N>>::iterator first,
+				typename std::vector<Entry<N>>::iterator last,
+				unsigned parts,
+				unsigned depth,
+				std::vector<Entry<N>> * partitions
+			) const;
+
+
+		/**
+		 * Tile a range of entries into nodes (the recursive part of STR).
+		 *
+		 * @param first Iterator to first entry
+		 * @param last Past-the-end iterator
+		 * @param nodes Number of nodes to create from the range
+		 * @param dimension Dimension to sort and cut along
+		 * @param parents Destination for the entries of the new nodes
+		 */
+		template<class RandomIt>
+		void tile(
+				RandomIt first,
+				RandomIt last,
+				std::size_t nodes,
+				unsigned dimension,
+				std::vector<Entry<N>>& parents
+			) const;
+
+		/**
+		 * Deletes the nodes in this tree.
+		 *
+		 * Traverse the tree and delete all nodes on the way.
+		 *
+		 * @param root Root node of tree to delete
+		 * @param height Height of given tree
+		 */
+		void deleteTree(N& root, unsigned height);
+};
+
+/*
+ ___                 _                           _        _   _             
+|_ _|_ __ ___  _ __ | | ___ _ __ ___   ___ _ __ | |_ __ _| |_(_) ___  _ __  
+ | || '_ ` _ \| '_ \| |/ _ \ '_ ` _ \ / _ \ '_ \| __/ _` | __| |/ _ \| '_ \ 
+ | || | | | | | |_) | |  __/ | | | | |  __/ | | | || (_| | |_| | (_) | | | |
+|___|_| |_| |_| .__/|_|\___|_| |_| |_|\___|_| |_|\__\__,_|\__|_|\___/|_| |_|
+              |_|                                                           
+*/
+template <class N, unsigned m>
+Rtree<N, m>::Rtree() : height(0)
+{
+};
+
+template <class N, unsigned m>
+Rtree<N, m>::~Rtree()
+{
+	// The arena releases the memory of all nodes at once. The root is a data
+	// object below height 2.
+	if (!std::is_trivially_destructible<N>::value && getHeight() > 1) {
+		deleteTree(getRoot().getNode(), getHeight());
+	}
+};
+
+
+template <class N, unsigned m>
+const unsigned& Rtree<N, m>::getHeight() const
+{
+	return height;
+};
+
+
+template <class N, unsigned m>
+Entry<N>& Rtree<N, m>::getRoot()
+{
+	return root;
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::addLevel(const Entry<N>& newRoot)
+{
+	setRoot(newRoot, height + 1);
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::setRoot(const Entry<N>& newRoot, unsigned newHeight)
+{
+	if (newHeight > MAX_HEIGHT) {
+		throw std::length_error("R-tree exceeds maximum height");
+	}
+
+	root = newRoot;
+	height = newHeight;
+};
+
+
+template <class N, unsigned m>
+bool Rtree<N, m>::remove(const DataObject& object)
+{
+	// Root is a data object?
+	if (getHeight() < 2) {
+		if (getHeight() == 1 && root.getId() == object.getId()) {
+			setRoot(Entry<N>(), 0);
+			return true;
+		}
+
+		return false;
+	}
+
+	std::vector<typename N::iterator> path = findPath(object);
+
+	if (path.empty()) {
+		return false;
+	}
+
+	erase(path);
+	return true;
+};
+
+
+template <class N, unsigned m>
+bool Rtree<N, m>::update(Id id, const Box& oldBox, const Box& newBox)
+{
+	const DataObject object (id, newBox);
+
+	// Root is a data object?
+	if (getHeight() < 2) {
+		if (getHeight() == 1 && root.getId() == id) {
+			root = createEntry(object);
+			return true;
+		}
+
+		return false;
+	}
+
+	std::vector<typename N::iterator> path = findPath(DataObject(id, oldBox));
+
+	if (path.empty()) {
+		return false;
+	}
+
+	if (!relocate(path, createEntry(object))) {
+		erase(path);
+		insert(object);
+	}
+
+	return true;
+};
+
+
+template <class N, unsigned m>
+bool Rtree<N, m>::relocate(
+		std::vector<typename N::iterator>& path,
+		const Entry<N>& entry
+	)
+{
+	if (patch(path, entry)) {
+		return true;
+	}
+
+	auto object = path.back();
+	N& leaf = object.getContainingNode();
+
+	// Move to a sibling leaf?
+	if (path.size() < 2 || leaf.getSize() <= std::max(m, 1u)) {
+		return false;
+	}
+
+	auto leafEntry = path.end()[-2];
+	N& parent = leafEntry.getContainingNode();
+
+	for (auto sibling = parent.begin(); sibling != parent.end(); ++sibling) {
+		if (
+				sibling == leafEntry ||
+				sibling->getNode().isFull() ||
+				!sibling->getMbr().contains(entry.getMbr())
+		) {
+			continue;
+		}
+
+		leaf.erase(object);
+		sibling->getNode().add(entry);
+		sibling->include(entry);
+		tighten(path);
+
+		return true;
+	}
+
+	return false;
+};
+
+
+template <class N, unsigned m>
+bool Rtree<N, m>::patch(
+		std::vector<typename N::iterator>& path,
+		const Entry<N>& entry
+	)
+{
+	// The leaf's own entry and the entry of its parent
+	const M leafMbr = path.size() > 1
+		? path.end()[-2]->getMbr()
+		: root.getMbr();
+
+	const M parentMbr = path.size() > 2
+		? path.end()[-3]->getMbr()
+		: root.getMbr();
+
+	if (
+			!leafMbr.contains(entry.getMbr()) &&
+			!parentMbr.contains(leafMbr + entry.getMbr())
+	) {
+		return false;
+	}
+
+	*path.back() = entry;
+	tighten(path);
+
+	return true;
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::tighten(std::vector<typename N::iterator>& path)
+{
+	for (auto it = path.rbegin() + 1; it != path.rend(); ++it) {
+		(*it)->recalculate();
+	}
+
+	root.recalculate();
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::erase(std::vector<typename N::iterator>& path)
+{
+	path.back().getContainingNode().erase(path.back());
+	path.pop_back();
+
+	std::vector<Entry<N>> orphans;
+	condense(path, orphans);
+
+	// Remove the root while it has a single child
+	while (getHeight() > 1 && root.getNode().getSize() == 1) {
+		N * node = &root.getNode();
+		setRoot((*node)[0], height - 1);
+		destroyNode(node);
+	}
+
+	if (getHeight() > 1) {
+		root.recalculate();
+	}
+
+	for (const Entry<N>& orphan : orphans) {
+		insert(DataObject(orphan.getId(), orphan.getMbr().toBox()));
+	}
+};
+
+
+template <class N, unsigned m>
+std::vector<typename N::iterator> Rtree<N, m>::findPath(
+		const DataObject& object
+	)
+{
+	const M mbr (object.getBox());
+
+	std::vector<typename N::iterator> path {root.getNode().begin()};
+
+	while (!path.empty()) {
+		auto& top = path.back();
+
+		// Finished this node?
+		if (top == top.getContainingNode().end()) {
+			path.pop_back();
+
+			if (!path.empty()) {
+				++path.back();
+			}
+
+			continue;
+		}
+
+		if (!top->getMbr().contains(mbr)) {
+			++top;
+		} else if (path.size() < getHeight() - 1) {
+			path.push_back(top->getNode().begin());
+		} else if (top->getId() == object.getId()) {
+			return path;
+		} else {
+			++top;
+		}
+	}
+
+	return path;
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::condense(
+		std::vector<typename N::iterator>& path,
+		std::vector<Entry<N>>& orphans
+	)
+{
+	while (!path.empty()) {
+		auto entry = path.back();
+		N& node = entry->getNode();
+
+		if (node.getSize() < std::max(m, 1u)) {
+			// Data objects are reinserted, not the subtrees
+			release(node, getHeight() - path.size(), orphans);
+			entry.getContainingNode().erase(entry);
+		} else {
+			entry->recalculate();
+		}
+
+		path.pop_back();
+	}
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::release(
+		N& node,
+		unsigned height,
+		std::vector<Entry<N>>& entries
+	)
+{
+	if (height < 3) {
+		entries.insert(entries.end(), node.begin(), node.end());
+	} else {
+		for (auto e : node) {
+			release(e.getNode(), height - 1, entries);
+		}
+	}
+
+	destroyNode(&node);
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::setFillFactor(double fill)
+{
+	if (fill <= 0.0 || fill > 1.0) {
+		throw std::invalid_argument("Fill factor must be in (0, 1]");
+	}
+
+	this->fill = fill;
+};
+
+
+template <class N, unsigned m>
+N * Rtree<N, m>::createNode(std::initializer_list<Entry<N>> entries) const
+{
+	return ::new (arena.allocate()) N(entries);
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::destroyNode(N * node) const
+{
+	node->~N();
+	arena.release(node);
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::setPages(Pages pages)
+{
+	arena.setPages(pages);
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::setPrefetch(unsigned distance, unsigned lines)
+{
+	const unsigned nodeLines = (sizeof(N) - 1) / Arena::LINE_SIZE + 1;
+
+	prefetchDistance = distance;
+	prefetchLines = std::max(1u, std::min(lines, nodeLines));
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::prefetch(const N& node) const
+{
+	const char * start = reinterpret_cast<const char *>(&node);
+
+	for (unsigned i = 0; i < prefetchLines; ++i) {
+		__builtin_prefetch(start + i * Arena::LINE_SIZE);
+	}
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::bulkLoad(const std::vector<DataObject>& objects)
+{
+	if (getHeight() != 0) {
+		throw std::logic_error("Bulk loading requires an empty tree");
+	}
+
+	if (objects.empty()) {
+		return;
+	}
+
+	std::vector<Entry<N>> entries (objects.size());
+
+#	ifdef _OPENMP
+#	pragma omp parallel for schedule(static)
+#	endif
+	for (std::size_t i = 0; i < objects.size(); ++i) {
+		entries[i] = createEntry(objects[i]);
+	}
+
+	// Use one partition per thread, but only if each partition gets enough
+	// entries to fill a couple of levels
+	unsigned threads = 1;
+
+#	ifdef _OPENMP
+	threads = omp_get_max_threads();
+#	endif
+
+	unsigned parts = std::max<std::size_t>(
+			std::min<std::size_t>(
+					threads,
+					entries.size() / (N::capacity * N::capacity)
+				),
+			1
+		);
+
+	std::vector<std::vector<Entry<N>>> partitions (parts);
+
+#	ifdef _OPENMP
+#	pragma omp parallel
+#	pragma omp single
+#	endif
+	partition(entries.begin(), entries.end(), parts, 0, partitions.data());
+
+	// Pack the partitions separately as long as all of them can fill nodes
+	unsigned levels = 1;
+
+	auto packable = [&]() {
+		return std::all_of(
+				partitions.begin(), partitions.end(),
+				[](const std::vector<Entry<N>>& part) {
+					return part.size() >= N::capacity;
+				}
+			);
+	};
+
+	while (packable()) {
+#		ifdef _OPENMP
+#		pragma omp parallel for schedule(dynamic, 1)
+#		endif
+		for (unsigned i = 0; i < parts; ++i) {
+			std::vector<Entry<N>> parents;
+			parents.reserve(nodeCount(partitions[i].size()));
+
+			pack(partitions[i], parents);
+
+			partitions[i].swap(parents);
+		}
+
+		levels++;
+	}
+
+	// Pack the upper levels on top of all partitions
+	entries.clear();
+
+	for (const auto& part : partitions) {
+		entries.insert(entries.end(), part.begin(), part.end());
+	}
+
+	while (entries.size() > 1) {
+		std::vector<Entry<N>> parents;
+		parents.reserve(nodeCount(entries.size()));
+
+		pack(entries, parents);
+
+		entries.swap(parents);
+		levels++;
+	}
+
+	setRoot(entries.front(), levels);
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::partition(
+		typename std::vector<Entry<N>>::iterator first,
+		typename std::vector<Entry<N>>::iterator last,
+		unsigned parts,
+		unsigned depth,
+		std::vector<Entry<N>> * partitions
+	) const
+{
+	if (parts == 1) {
+		partitions->assign(first, last);
+		return;
+	}
+
+	unsigned lower = parts / 2;
+	auto middle = first + (last - first) * lower / parts;
+
+	split(first, middle, last, depth);
+
+#	ifdef _OPENMP
+#	pragma omp task
+#	endif
+	partition(first, middle, lower, depth + 1, partitions);
+
+	partition(middle, last, parts - lower, depth + 1, partitions + lower);
+
+#	ifdef _OPENMP
+#	pragma omp taskwait
+#	endif
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::split(
+		typename std::vector<Entry<N>>::iterator first,
+		typename std::vector<Entry<N>>::iterator middle,
+		typename std::vector<Entry<N>>::iterator last,
+		unsigned depth
+	) const
+{
+	unsigned dimension = depth % M::dimension;
+
+	std::nth_element(
+			first, middle, last,
+			[&](const Entry<N>& a, const Entry<N>& b) {
+				M ma = a.getMbr();
+				M mb = b.getMbr();
+
+				return ma.getBottom()[dimension] + ma.getTop()[dimension]
+					< mb.getBottom()[dimension] + mb.getTop()[dimension];
+			}
+		);
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::pack(
+		std::vector<Entry<N>>& entries,
+		std::vector<Entry<N>>& parents
+	)
+{
+	tile(
+			entries.begin(), entries.end(),
+			nodeCount(entries.size()),
+			0,
+			parents
+		);
+};
+
+
+template <class N, unsigned m>
+std::size_t Rtree<N, m>::nodeCount(std::size_t entries) const
+{
+	std::size_t perNode = std::min<std::size_t>(
+			std::max<long>(std::lround(fill * N::capacity), std::max(m, 1u)),
+			N::capacity
+		);
+
+	std::size_t nodes = (entries + perNode - 1) / perNode;
+
+	// Fewer nodes (with more entries) is better than underfull nodes
+	return std::max<std::size_t>(
+			std::min<std::size_t>(nodes, entries / std::max(m, 1u)),
+			1
+		);
+};
+
+
+template <class N, unsigned m>
+template<class RandomIt>
+void Rtree<N, m>::distribute(
+		RandomIt first,
+		RandomIt last,
+		std::size_t nodes,
+		std::vector<Entry<N>>& parents
+	) const
+{
+	std::size_t size = (last - first) / nodes;
+	std::size_t leftover = (last - first) % nodes;
+
+	for (std::size_t i = 0; i < nodes; ++i) {
+		RandomIt end = first + size + (i < leftover);
+
+		N * node = createNode({});
+		node->assign(first, end);
+		parents.emplace_back(node);
+
+		first = end;
+	}
+};
+
+
+template <class N, unsigned m>
+template<class RandomIt>
+void Rtree<N, m>::tile(
+		RandomIt first,
+		RandomIt last,
+		std::size_t nodes,
+		unsigned dimension,
+		std::vector<Entry<N>>& parents
+	) const
+{
+	constexpr unsigned D = M::dimension;
+
+	if (nodes > 1) {
+		std::sort(
+				first, last,
+				[&](const Entry<N>& a, const Entry<N>& b) {
+					M ma = a.getMbr();
+					M mb = b.getMbr();
+
+					return ma.getBottom()[dimension] + ma.getTop()[dimension]
+						< mb.getBottom()[dimension] + mb.getTop()[dimension];
+				}
+			);
+	}
+
+	if (nodes == 1 || dimension == D - 1) {
+		distribute(first, last, nodes, parents);
+		return;
+	}
+
+	// Use s slabs such that s^(remaining dimensions) >= nodes
+	std::size_t slabs = 1;
+
+	while (std::pow(slabs, D - dimension) < nodes) {
+		slabs++;
+	}
+
+	// Cut slabs at node boundaries, such that all nodes on this level end
+	// up with the same number of entries (+/- 1)
+	std::size_t size = (last - first) / nodes;
+	std::size_t leftover = (last - first) % nodes;
+	std::size_t node = 0;
+
+	for (std::size_t i = 0; i < slabs; ++i) {
+		std::size_t slabNodes = nodes / slabs + (i < nodes % slabs);
+		std::size_t slabLeftover = std::min(
+				leftover - std::min(leftover, node),
+				slabNodes
+			);
+
+		RandomIt end = first + slabNodes * size + slabLeftover;
+
+		tile(first, end, slabNodes, dimension + 1, parents);
+
+		first = end;
+		node += slabNodes;
+	}
+
+	assert(first == last);
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::checkStructure() const
+{
+	traverse([&](const Entry<N>& entry, unsigned level) {
+		// Skip leafs
+		if (level == height) {
+			return false;
+		}
+
+		// Check child count
+		const unsigned& size = entry.getNode().getSize();
+
+		if (size > N::capacity) {
+			throw InvalidStructureError(
+					"Too many children of node"
+				);
+		}
+
+		if (size < (level == 1 ? 2 : m)) {
+			throw InvalidStructureError(
+					"Too few children at level " + std::to_string(level)
+				);
+		}
+
+		// Check MBR containment
+		N& node = entry.getNode();
+		M mbr = node[0].getMbr();
+
+		for (const auto& e : node) {
+			if (!entry.getMbr().contains(e.getMbr())) {
+				throw InvalidStructureError(
+						"Node not contained within parent at level " +
+						std::to_string(level)
+					);
+			}
+
+			mbr += e.getMbr();
+		}
+
+		if (N::tight && mbr != entry.getMbr()) {
+			throw InvalidStructureError(
+					"MBR too large at level " + std::to_string(level)
+				);
+		}
+
+
+		return true;
+	});
+}
+
+
+template <class N, unsigned m>
+StatsCollector Rtree<N, m>::collectStatistics() const
+{
+	StatsCollector stats;
+
+	stats["height"] = height;
+	stats["nodes"] = 0;
+	stats["level_" + std::to_string(height)] = 1;
+
+	traverse([&](const Entry<N>& entry, unsigned level) {
+		// Skip leafs
+		if (level == height) {
+			return false;
+		}
+
+		std::string key = "level_" + std::to_string(height - level);
+		stats[key] += entry.getNode().getSize();
+		stats["nodes"]++;
+		return true;
+	});
+
+	return stats;
+};
+
+
+template <class N, unsigned m>
+StatsCollector Rtree<N, m>::collectMemoryStatistics() const
+{
+	StatsCollector stats = arena.collectStatistics();
+	stats["node_bytes"] = sizeof(N);
+
+	return stats;
+};
+
+
+template <class N, unsigned m>
+template<class F>
+void Rtree<N, m>::traverse(F visitor) const
+{
+	if (height < 2) {
+		return;
+	}
+
+	using EIt = typename N::const_iterator;
+
+	const N& rootNode = root.getNode();
+
+	if (!visitor(root, 1)) {
+		return;
+	}
+
+	if (height == 2) {
+		return;
+	}
+
+	// Store start and end iterators for each level
+	std::vector<std::pair<EIt, EIt>> path {
+			{rootNode.begin(), rootNode.end()}
+		};
+
+	while (!path.empty()) {
+		auto& top = path.back();
+
+		// Have we finished this node?
+		if (top.first == top.second) {
+			path.pop_back();
+			continue;
+		}
+
+		const Entry<N> entry = *(top.first++);
+
+		// Call visitor
+		bool descend = visitor(entry, path.size() + 1);
+
+		// Push children (if they exist)
+		if (descend && path.size() < getHeight() - 1) {
+			const N& node = entry.getNode();
+			path.emplace_back(node.begin(), node.end());
+		}
+	}
+}
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::rangeSearch(ResultSink& sink, const Box& box) const
+{
+	predicateSearch(sink, box, Predicate::INTERSECTS);
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::predicateSearch(
+		ResultSink& sink,
+		const Box& box,
+		Predicate predicate
+	) const
+{
+	using Ref = typename NIt::reference;
+	using Mbr = typename N::Mbr;
+
+	const Mbr query (box);
+
+	// Predicate for entries above the leaves
+	const Predicate inner = predicate == Predicate::WITHIN
+		? Predicate::INTERSECTS
+		: predicate;
+
+	// Empty tree or root is a data object?
+	if (getHeight() < 2) {
+		if (getHeight() == 1 && root.getMbr().matches(query, predicate)) {
+			sink.push(root.getId());
+		}
+
+		return;
+	}
+
+	if (prefetchDistance) {
+		prefetchSearch(sink, query, predicate);
+		return;
+	}
+
+	// "Stack" used during search, kept local to allow concurrent searches
+	std::pair<NIt, NIt> path[MAX_HEIGHT];
+	unsigned depth = 0;
+
+	// "Scan" root node
+	path[depth++] = root.getNode().scan(
+			query,
+			root,
+			getHeight() == 2 ? predicate : inner
+		);
+
+	while (depth) {
+		auto& top = path[depth - 1];
+
+		if (top.first == top.second) {
+			--depth;
+			continue;
+		}
+
+		// Find node to descend into
+		const Ref& entry = (*top.first);
+
+		if (depth < getHeight() - 1) {
+			// Is the node a leaf?
+			const Predicate next = depth + 2 == getHeight() ? predicate : inner;
+			path[depth++] = entry.getNode().scan(query, entry, next);
+		} else if (!sink.push(entry.getId())) {
+			return;
+		}
+
+		++top.first;
+	}
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::prefetchSearch(
+		ResultSink& sink,
+		const M& query,
+		Predicate predicate
+	) const
+{
+	using Ref = typename NIt::reference;
+	using Proxy = ProxyEntry<const N>;
+
+	const Predicate inner = predicate == Predicate::WITHIN
+		? Predicate::INTERSECTS
+		: predicate;
+
+	// Node being scanned on each level, in frames of this thread to allow
+	// concurrent searches. The matching children of the nodes above the
+	// leaves are collected up front, such that they can be prefetched ahead
+	// of the descent into them.
+	struct Frame
+	{
+		std::pair<NIt, NIt> scan;
+		const N * node;
+		unsigned next;
+		unsigned size;
+		unsigned children[N::capacity];
+	};
+
+	ScratchFrames<Frame> path (getHeight() - 1);
+	unsigned depth = 0;
+
+	auto enter = [&](const N& node, std::pair<NIt, NIt> scan) {
+		Frame& frame = path[depth++];
+
+		// The data entries of leaves are reported straight from the scan
+		if (depth == getHeight() - 1) {
+			frame.scan = scan;
+			return;
+		}
+
+		frame.node = &node;
+		frame.next = 0;
+		frame.size = 0;
+
+		for (; scan.first != scan.second; ++scan.first) {
+			frame.children[frame.size++] = (*scan.first).index;
+		}
+
+		for (unsigned i = 0; i < std::min(prefetchDistance, frame.size); ++i) {
+			prefetch(node.getLink(frame.children[i]).getNode());
+		}
+	};
+
+	// "Scan" root node
+	enter(
+			root.getNode(),
+			root.getNode().scan(
+				query,
+				root,
+				getHeight() == 2 ? predicate : inner
+			)
+		);
+
+	while (depth) {
+		Frame& top = path[depth - 1];
+
+		if (depth < getHeight() - 1) {
+			if (top.next == top.size) {
+				--depth;
+				continue;
+			}
+
+			// Keep the prefetches the same distance ahead
+			const unsigned ahead = top.next + prefetchDistance;
+
+			if (ahead < top.size) {
+				prefetch(top.node->getLink(top.children[ahead]).getNode());
+			}
+
+			// Find node to descend into. Is it a leaf?
+			const Proxy entry (top.node, top.children[top.next++]);
+			const Predicate next = depth + 2 == getHeight() ? predicate : inner;
+			enter(entry.getNode(), entry.getNode().scan(query, entry, next));
+			continue;
+		}
+
+		if (top.scan.first == top.scan.second) {
+			--depth;
+			continue;
+		}
+
+		const Ref& entry = (*top.scan.first);
+
+		if (!sink.push(entry.getId())) {
+			return;
+		}
+
+		++top.scan.first;
+	}
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::levelSearch(
+		ResultSink& sink,
+		const Box& box,
+		Predicate predicate
+	) const
+{
+	using Ref = typename NIt::reference;
+	using Proxy = ProxyEntry<const N>;
+
+	const M query (box);
+
+	// Node on the frontier, along with its entry in the parent. Proxy
+	// entries assign to the node they refer to, thus cannot be sorted.
+	struct Visit
+	{
+		const N * node;
+		const N * parent;
+		unsigned index;
+	};
+
+	const Predicate inner = predicate == Predicate::WITHIN
+		? Predicate::INTERSECTS
+		: predicate;
+
+	// Empty tree or root is a data object?
+	if (getHeight() < 2) {
+		if (getHeight() == 1 && root.getMbr().matches(query, predicate)) {
+			sink.push(root.getId());
+		}
+
+		return;
+	}
+
+	std::vector<Visit> frontier, next;
+
+	// Report the matching data entries of a leaf, or add the matching nodes
+	// below any other node to the next frontier
+	auto collect = [&](std::pair<NIt, NIt> scan, bool leaf) -> bool {
+		for (; scan.first != scan.second; ++scan.first) {
+			const Ref& entry = (*scan.first);
+
+			if (!leaf) {
+				next.push_back({&entry.getNode(), entry.node, entry.index});
+			} else if (!sink.push(entry.getId())) {
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	const bool rootLeaf = getHeight() == 2;
+	const Predicate rootPredicate = rootLeaf ? predicate : inner;
+
+	if (!collect(root.getNode().scan(query, root, rootPredicate), rootLeaf)) {
+		return;
+	}
+
+	// The root is on level 1, and the leaves on the level above the objects
+	for (unsigned level = 2; level < getHeight() && !next.empty(); ++level) {
+		std::swap(frontier, next);
+		next.clear();
+
+		// Nodes are allocated in chunks, thus mostly visited in a stream
+		std::sort(
+				frontier.begin(),
+				frontier.end(),
+				[](const Visit& a, const Visit& b) {
+					return std::less<const N *>()(a.node, b.node);
+				}
+			);
+
+		const bool leaf = level == getHeight() - 1;
+		const Predicate levelPredicate = leaf ? predicate : inner;
+
+		for (std::size_t i = 0; i < frontier.size(); ++i) {
+			if (prefetchDistance && i + prefetchDistance < frontier.size()) {
+				prefetch(*frontier[i + prefetchDistance].node);
+			}
+
+			const Visit& visit = frontier[i];
+			const Proxy entry (visit.parent, visit.index);
+			const N& node = *visit.node;
+
+			if (!collect(node.scan(query, entry, levelPredicate), leaf)) {
+				return;
+			}
+		}
+	}
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::radiusSearch(
+		ResultSink& sink,
+		const Box& box,
+		double radius
+	) const
+{
+	using Mbr = typename N::Mbr;
+
+	const Mbr query (box);
+	const double radius2 = radius * radius;
+
+	// Empty tree or root is a data object?
+	if (getHeight() < 2) {
+		if (getHeight() == 1 && root.getMbr().distance2(query) <= radius2) {
+			sink.push(root.getId());
+		}
+
+		return;
+	}
+
+	// Node being scanned on each level, along with the distances of its
+	// entries and the entry prefetched ahead, in frames of this thread to
+	// allow concurrent searches
+	struct Frame
+	{
+		const N * node;
+		unsigned next;
+		unsigned ahead;
+		double distances[N::capacity];
+	};
+
+	ScratchFrames<Frame> path (getHeight() - 1);
+	unsigned depth = 0;
+
+	// Prefetch the nodes of the next matching entries
+	auto prefetchAhead = [&](Frame& frame, unsigned count) {
+		for (; count && frame.ahead < frame.node->getSize(); ++frame.ahead) {
+			if (frame.distances[frame.ahead] <= radius2) {
+				prefetch(frame.node->getLink(frame.ahead).getNode());
+				--count;
+			}
+		}
+	};
+
+	auto enter = [&](const N& node) {
+		Frame& frame = path[depth++];
+		frame.node = &node;
+		frame.next = 0;
+		frame.ahead = 0;
+		node.scanDistance(query, frame.distances);
+
+		if (prefetchDistance && depth < getHeight() - 1) {
+			prefetchAhead(frame, prefetchDistance);
+		}
+	};
+
+	enter(root.getNode());
+
+	while (depth) {
+		Frame& top = path[depth - 1];
+
+		if (top.next == top.node->getSize()) {
+			--depth;
+			continue;
+		}
+
+		const unsigned i = top.next++;
+
+		if (top.distances[i] > radius2) {
+			continue;
+		}
+
+		if (depth < getHeight() - 1) {
+			if (prefetchDistance) {
+				prefetchAhead(top, 1);
+			}
+
+			enter(top.node->getLink(i).getNode());
+		} else if (!sink.push(top.node->getLink(i).getId())) {
+			return;
+		}
+	}
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::distanceJoin(
+		PairSink& sink,
+		const SpatialIndex& other,
+		double distance
+	) const
+{
+	const Rtree * tree = dynamic_cast<const Rtree *>(&other);
+
+	if (tree == nullptr) {
+		SpatialIndex::distanceJoin(sink, other, distance);
+		return;
+	}
+
+	if (
+			!getHeight() || !tree->getHeight()
+			|| root.getMbr().distance2(tree->root.getMbr())
+				> distance * distance
+	) {
+		return;
+	}
+
+	// Each level of recursion descends at least one of the trees
+	const unsigned levels = 2 * (getHeight() + tree->getHeight());
+
+#	ifdef _OPENMP
+	const unsigned threads = omp_get_max_threads();
+
+	if (threads > 1 && !omp_in_parallel()) {
+		JoinState state;
+		state.distance = distance;
+		state.stopped = false;
+		state.buffers.resize(
+				threads,
+				std::vector<std::vector<Entry<N>>>(levels)
+			);
+
+		for (unsigned i = 0; i < threads; ++i) {
+			state.sinks.emplace_back(new SharedPairSink(sink));
+		}
+
+#		pragma omp parallel num_threads(threads)
+#		pragma omp single
+		joinTasks(root, getHeight(), tree->root, tree->getHeight(), &state);
+
+		for (const auto& local : state.sinks) {
+			local->finish();
+		}
+
+		return;
+	}
+#	endif
+
+	std::vector<std::vector<Entry<N>>> buffers (levels);
+
+	joinEntries(
+			sink,
+			root, getHeight(),
+			tree->root, tree->getHeight(),
+			distance,
+			buffers.data()
+		);
+};
+
+
+template <class N, unsigned m>
+bool Rtree<N, m>::joinEntries(
+		PairSink& sink,
+		const Entry<N>& left,
+		unsigned leftHeight,
+		const Entry<N>& right,
+		unsigned rightHeight,
+		double distance,
+		std::vector<Entry<N>> * buffers
+	)
+{
+	if (leftHeight == 1 && rightHeight == 1) {
+		return sink.push(left.getId(), right.getId());
+	}
+
+	return sweep(
+			left, leftHeight,
+			right, rightHeight,
+			distance,
+			buffers[0], buffers[1],
+			[&sink, distance, buffers](
+					const Entry<N>& l,
+					unsigned lh,
+					const Entry<N>& r,
+					unsigned rh
+				) {
+				return joinEntries(sink, l, lh, r, rh, distance, buffers + 2);
+			}
+		);
+};
+
+
+template <class N, unsigned m>
+template <class F>
+bool Rtree<N, m>::sweep(
+		const Entry<N>& left,
+		unsigned leftHeight,
+		const Entry<N>& right,
+		unsigned rightHeight,
+		double distance,
+		std::vector<Entry<N>>& lefts,
+		std::vector<Entry<N>>& rights,
+		F visitor
+	)
+{
+	const double distance2 = distance * distance;
+
+	// Without a distance, the cheaper intersection test does
+	auto near = [distance, distance2](const M& a, const M& b) {
+		return distance == 0.0 ? a.intersects(b) : a.distance2(b) <= distance2;
+	};
+
+	// Only children near the other entry may be near anything in it
+	auto collect = [distance](
+			std::vector<Entry<N>>& candidates,
+			const Entry<N>& entry,
+			const Entry<N>& other,
+			bool descend
+		) {
+		candidates.clear();
+
+		if (!descend) {
+			candidates.push_back(entry);
+			return;
+		}
+
+		// The iterators refer to the window
+		const M window = other.getMbr().expanded(distance);
+		auto range = entry.getNode().scan(window, entry);
+
+		for (; range.first != range.second; ++range.first) {
+			candidates.push_back(*range.first);
+		}
+
+		std::sort(
+				candidates.begin(), candidates.end(),
+				[](const Entry<N>& a, const Entry<N>& b) {
+					return a.getMbr().getBottom()[0] < b.getMbr().getBottom()[0];
+				}
+			);
+	};
+
+	const bool descendLeft = leftHeight >= rightHeight;
+	const bool descendRight = rightHeight >= leftHeight;
+
+	collect(lefts, left, right, descendLeft);
+	collect(rights, right, left, descendRight);
+
+	const unsigned nextLeft = descendLeft ? leftHeight - 1 : leftHeight;
+	const unsigned nextRight = descendRight ? rightHeight - 1 : rightHeight;
+
+	// Plane sweep: Take the entry with the lowest bottom and pair it with
+	// the entries of the other list starting before its top (plus the
+	// distance)
+	auto l = lefts.cbegin();
+	auto r = rights.cbegin();
+
+	while (l != lefts.cend() && r != rights.cend()) {
+		const M lm = l->getMbr();
+		const M rm = r->getMbr();
+
+		if (lm.getBottom()[0] <= rm.getBottom()[0]) {
+			for (auto it = r; it != rights.cend(); ++it) {
+				const M mbr = it->getMbr();
+
+				if (mbr.getBottom()[0] > lm.getTop()[0] + distance) {
+					break;
+				}
+
+				if (
+						near(lm, mbr)
+						&& !visitor(*l, nextLeft, *it, nextRight)
+				) {
+					return false;
+				}
+			}
+
+			++l;
+		} else {
+			for (auto it = l; it != lefts.cend(); ++it) {
+				const M mbr = it->getMbr();
+
+				if (mbr.getBottom()[0] > rm.getTop()[0] + distance) {
+					break;
+				}
+
+				if (
+						near(rm, mbr)
+						&& !visitor(*it, nextLeft, *r, nextRight)
+				) {
+					return false;
+				}
+			}
+
+			++r;
+		}
+	}
+
+	return true;
+};
+
+
+#ifdef _OPENMP
+template <class N, unsigned m>
+void Rtree<N, m>::joinTasks(
+		const Entry<N>& left,
+		unsigned leftHeight,
+		const Entry<N>& right,
+		unsigned rightHeight,
+		JoinState * state
+	)
+{
+	if (state->stopped) {
+		return;
+	}
+
+	// Pairs of data entries (only two single object trees get here)
+	if (leftHeight == 1 && rightHeight == 1) {
+		if (!state->sinks[omp_get_thread_num()]->push(
+				left.getId(), right.getId()
+			)) {
+			state->stopped = true;
+		}
+
+		return;
+	}
+
+	std::vector<Entry<N>> lefts, rights;
+	std::vector<std::pair<Entry<N>, Entry<N>>> pairs;
+	unsigned nextLeft = 0;
+	unsigned nextRight = 0;
+
+	sweep(
+			left, leftHeight,
+			right, rightHeight,
+			state->distance,
+			lefts, rights,
+			[&](
+					const Entry<N>& l,
+					unsigned lh,
+					const Entry<N>& r,
+					unsigned rh
+				) {
+				pairs.emplace_back(l, r);
+				nextLeft = lh;
+				nextRight = rh;
+				return true;
+			}
+		);
+
+	if (nextLeft + nextRight > JOIN_TASK_HEIGHT) {
+		for (std::size_t i = 0; i < pairs.size(); ++i) {
+#			pragma omp task shared(pairs) firstprivate(i)
+			joinTasks(
+					pairs[i].first, nextLeft,
+					pairs[i].second, nextRight,
+					state
+				);
+		}
+	} else {
+		for (std::size_t first = 0; first < pairs.size(); first += JOIN_CHUNK) {
+#			pragma omp task shared(pairs) firstprivate(first)
+			{
+				const unsigned thread = omp_get_thread_num();
+				PairSink& sink = *state->sinks[thread];
+				std::vector<Entry<N>> * buffers = state->buffers[thread].data();
+				const std::size_t last = pairs.size() - first > JOIN_CHUNK
+					? first + JOIN_CHUNK
+					: pairs.size();
+
+				for (std::size_t i = first; i < last && !state->stopped; ++i) {
+					if (!joinEntries(
+							sink,
+							pairs[i].first, nextLeft,
+							pairs[i].second, nextRight,
+							state->distance,
+							buffers
+						)) {
+						state->stopped = true;
+					}
+				}
+			}
+		}
+	}
+
+	// The tasks refer to the pairs
+#	pragma omp taskwait
+};
+#endif
+
+
+template <class N, unsigned m>
+unsigned long long Rtree<N, m>::count(const Box& box) const
+{
+	return count(box, IsAggregate<typename N::Plugin>());
 };
 
 
 template <class N, unsigned m>
-const unsigned& Rtree<N, m>::getHeight() const
+template <class P>
+typename P::Value Rtree<N, m>::sum(const Box& box) const
 {
-	return height;
+	typename P::Value total = typename P::Value();
+
+	aggregate(box, [&](const P& plugin) {
+		total += plugin.getSum();
+	});
+
+	return total;
 };
 
 
 template <class N, unsigned m>
-Entry<N>& Rtree<N, m>::getRoot()
+unsigned long long Rtree<N, m>::count(const Box& box, std::true_type) const
 {
-	return root;
+	unsigned long long total = 0;
+
+	aggregate(box, [&](const typename N::Plugin& plugin) {
+		total += plugin.getCount();
+	});
+
+	return total;
 };
 
 
 template <class N, unsigned m>
-void Rtree<N, m>::addLevel(const Entry<N>& newRoot)
+unsigned long long Rtree<N, m>::count(const Box& box, std::false_type) const
 {
-	root = newRoot;
-	height++;
-
-	// Allocate stack to aviod allocation cost during benchmarking
-	if (path) {
-		delete[] path;
-	}
-	path = new std::pair<NIt, NIt>[height];
+	return SpatialIndex::count(box);
 };
 
 
 template <class N, unsigned m>
-void Rtree<N, m>::checkStructure() const
+template <class F>
+void Rtree<N, m>::aggregate(const Box& box, F visitor) const
 {
-	traverse([&](const Entry<N>& entry, unsigned level) {
-		// Skip leafs
-		if (level == height) {
-			return false;
-		}
+	const M query (box);
 
-		// Check child count
-		const unsigned& size = entry.getNode().getSize();
+	std::pair<NIt, NIt> path[MAX_HEIGHT];
+	unsigned depth = 0;
 
-		if (size > N::capacity) {
-			throw InvalidStructureError(
-					"Too many children of node"
-				);
-		}
+	if (getHeight() == 0 || !root.getMbr().intersects(query)) {
+		return;
+	}
 
-		if (size < (level == 1 ? 2 : m)) {
-			throw InvalidStructureError(
-					"Too few children at level " + std::to_string(level)
-				);
-		}
+	if (getHeight() == 1 || query.contains(root.getMbr())) {
+		visitor(root.getPlugin());
+		return;
+	}
 
-		// Check MBR containment
-		N& node = entry.getNode();
-		M mbr = node[0].getMbr();
+	path[depth++] = root.getNode().scan(query, root);
 
-		for (const auto& e : node) {
-			if (!entry.getMbr().contains(e.getMbr())) {
-				throw InvalidStructureError(
-						"Node not contained within parent at level " +
-						std::to_string(level)
-					);
-			}
+	while (depth) {
+		auto& top = path[depth - 1];
 
-			mbr += e.getMbr();
+		if (top.first == top.second) {
+			--depth;
+			continue;
 		}
 
-		if (mbr != entry.getMbr()) {
-			throw InvalidStructureError(
-					"MBR too large at level " + std::to_string(level)
-				);
-		}
+		const typename NIt::reference& entry = (*top.first);
 
+		// Only descend if some objects below may be outside the box
+		if (depth < getHeight() - 1 && !query.contains(entry.getMbr())) {
+			path[depth++] = entry.getNode().scan(query, entry);
+		} else {
+			visitor(entry.getPlugin());
+		}
 
-		return true;
-	});
-}
+		++top.first;
+	}
+};
 
 
 template <class N, unsigned m>
-StatsCollector Rtree<N, m>::collectStatistics() const
+void Rtree<N, m>::searchBatch(
+		const std::vector<RangeQuery>& queries,
+		const std::vector<ResultSink *>& sinks
+	) const
 {
-	StatsCollector stats;
+	if (queries.size() != sinks.size()) {
+		throw std::invalid_argument("Need one sink for each query");
+	}
 
-	stats["height"] = height;
-	stats["nodes"] = 0;
-	stats["level_" + std::to_string(height)] = 1;
+	// Group nearby queries, as they share most nodes
+	std::vector<std::pair<std::uint64_t, std::size_t>> order;
+	order.reserve(queries.size());
 
-	traverse([&](const Entry<N>& entry, unsigned level) {
-		// Skip leafs
-		if (level == height) {
-			return false;
-		}
+	const Box bounds = root.getMbr().toBox();
 
-		std::string key = "level_" + std::to_string(height - level);
-		stats[key] += entry.getNode().getSize();
-		stats["nodes"]++;
-		return true;
-	});
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		order.emplace_back(zOrder(queries[i].getBox(), bounds), i);
+	}
 
-	return stats;
-};
+	std::sort(order.begin(), order.end());
 
+	std::vector<M> mbrs;
+	std::vector<ResultSink *> sorted;
+	mbrs.reserve(queries.size());
+	sorted.reserve(queries.size());
 
-template <class N, unsigned m>
-template<class F>
-void Rtree<N, m>::traverse(F visitor) const
-{
-	if (height < 2) {
-		return;
+	for (const auto& query : order) {
+		mbrs.emplace_back(queries[query.second].getBox());
+		sorted.push_back(sinks[query.second]);
 	}
 
-	using EIt = typename N::const_iterator;
-
-	const N& rootNode = root.getNode();
-
-	if (!visitor(root, 1)) {
-		return;
+	for (std::size_t i = 0; i < queries.size(); i += BATCH_SIZE) {
+		searchGroup(
+				&mbrs[i],
+				&sorted[i],
+				std::min<std::size_t>(BATCH_SIZE, queries.size() - i)
+			);
 	}
 
-	if (height == 2) {
-		return;
+	for (ResultSink * sink : sinks) {
+		sink->finish();
 	}
+};
 
-	// Store start and end iterators for each level
-	std::vector<std::pair<EIt, EIt>> path {
-			{rootNode.begin(), rootNode.end()}
-		};
 
-	while (!path.empty()) {
-		auto& top = path.back();
+template <class N, unsigned m>
+std::uint64_t Rtree<N, m>::zOrder(const Box& box, const Box& bounds)
+{
+	constexpr unsigned D = M::dimension;
+	constexpr unsigned bits = 64 / D;
 
-		// Have we finished this node?
-		if (top.first == top.second) {
-			path.pop_back();
-			continue;
-		}
+	const auto& points = box.getPoints();
+	const auto& limits = bounds.getPoints();
+	std::uint64_t cells[D];
 
-		const Entry<N> entry = *(top.first++);
+	// Grid cell of the center, clamped to the bounds
+	for (unsigned d = 0; d < D; ++d) {
+		double extent = limits.second[d] - limits.first[d];
+		double center = (points.first[d] + points.second[d]) / 2.0;
+		double x = extent > 0.0 ? (center - limits.first[d]) / extent : 0.0;
 
-		// Call visitor
-		bool descend = visitor(entry, path.size() + 1);
+		cells[d] = std::min(std::max(x, 0.0), 1.0)
+			* ((std::uint64_t(1) << bits) - 1);
+	}
 
-		// Push children (if they exist)
-		if (descend && path.size() < getHeight() - 1) {
-			const N& node = entry.getNode();
-			path.emplace_back(node.begin(), node.end());
+	// Interleave the bits, most significant first
+	std::uint64_t code = 0;
+
+	for (unsigned b = bits; b-- > 0;) {
+		for (unsigned d = 0; d < D; ++d) {
+			code = (code << 1) | ((cells[d] >> b) & 1);
 		}
 	}
-}
+
+	return code;
+};
 
 
 template <class N, unsigned m>
-void Rtree<N, m>::rangeSearch(Results& results, const Box& box) const
+void Rtree<N, m>::searchGroup(
+		const M * queries,
+		ResultSink * const * sinks,
+		unsigned n
+	) const
 {
-	assert(getHeight() > 0);
+	using Mask = std::uint64_t;
+
+	// Node to visit, with the queries intersecting it
+	struct Visit {
+		Entry<N> entry;
+		Mask mask;
+		unsigned depth;
+	};
+
+	// Queries whose sinks have not asked to stop
+	Mask running = n < 64 ? (Mask(1) << n) - 1 : ~Mask(0);
+	Mask mask = 0;
+
+	for (unsigned q = 0; q < n; ++q) {
+		if (root.getMbr().intersects(queries[q])) {
+			mask |= Mask(1) << q;
+		}
+	}
 
-	using Ref = typename NIt::reference;
-	using Mbr = typename N::Mbr;
+	// Empty tree or root is a data object?
+	if (getHeight() < 2) {
+		for (; getHeight() == 1 && mask; mask &= mask - 1) {
+			sinks[__builtin_ctzll(mask)]->push(root.getId());
+		}
 
-	const Mbr query (box);
-	unsigned depth = 0;
+		return;
+	}
 
-	// "Scan" root node
-	path[depth++] = root.getNode().scan(query, root);
+	Mask masks[N::capacity];
+	std::vector<Visit> stack {{root, mask, 1}};
 
-	while (depth) {
-		auto& top = path[depth - 1];
+	while (!stack.empty()) {
+		const Visit visit = stack.back();
+		stack.pop_back();
 
-		if (top.first == top.second) {
-			--depth;
+		// Skip if all the queries have stopped
+		const Mask active = visit.mask & running;
+
+		if (!active) {
 			continue;
 		}
 
-		// Find node to descend into
-		const Ref& entry = (*top.first);
+		const N& node = visit.entry.getNode();
+		node.scanBatch(queries, active, masks, visit.entry);
 
-		if (depth < getHeight() - 1) {
-			path[depth++] = entry.getNode().scan(query, entry);
+		// Push results, or children in reverse to visit them in order
+		if (visit.depth == getHeight() - 1) {
+			for (unsigned i = 0; i < node.getSize(); ++i) {
+				for (Mask rest = masks[i] & running; rest; rest &= rest - 1) {
+					unsigned q = __builtin_ctzll(rest);
+
+					if (!sinks[q]->push(node.getLink(i).getId())) {
+						running &= ~(Mask(1) << q);
+					}
+				}
+			}
 		} else {
-			results.push_back(entry.getId());
+			for (unsigned i = node.getSize(); i-- > 0;) {
+				if (masks[i]) {
+					stack.push_back({node[i], masks[i], visit.depth + 1});
+				}
+			}
 		}
-
-		++top.first;
 	}
 };
 
@@ -449,24 +2628,215 @@ void Rtree<N, m>::rangeSearch(StatsCollector& stats, const Box& box) const
 
 
 template <class N, unsigned m>
-void Rtree<N, m>::knnSearch(Results&, unsigned, const Point&) const
+void Rtree<N, m>::knnSearch(
+		Results& results,
+		unsigned k,
+		const Point& point
+	) const
 {
-	throw std::runtime_error("k-NN search not implemented");
+	nearest(results, k, point, nullptr);
 };
 
 
-template<class N, unsigned m>
-void Rtree<N, m>::deleteTree(N& root, unsigned height)
+template <class N, unsigned m>
+void Rtree<N, m>::predicateSearch(
+		StatsCollector& stats,
+		const Box& box,
+		Predicate predicate
+	) const
 {
-	if (height < 3) {
+	const M query (box);
+
+	// Predicate for entries above the leaves
+	const Predicate inner = predicate == Predicate::WITHIN
+		? Predicate::INTERSECTS
+		: predicate;
+
+	stats["node_accesses"] = 0;
+	stats["leaf_accesses"] = 0;
+	stats["results"] = 0;
+
+	// Root is a data object?
+	if (height == 1 && root.getMbr().matches(query, predicate)) {
+		stats["results"]++;
+	}
+
+	traverse([&](const Entry<N>& entry, unsigned level) {
+			const Predicate check = level == height ? predicate : inner;
+
+			if (!entry.getMbr().matches(query, check)) {
+				return false;
+			}
+
+			if (level == height) {
+				stats["results"]++;
+				return false;
+			}
+
+			if (level == height - 1) {
+				stats["leaf_accesses"]++;
+			}
+
+			stats["node_accesses"]++;
+			return true;
+		});
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::radiusSearch(
+		StatsCollector& stats,
+		const Box& box,
+		double radius
+	) const
+{
+	const M query (box);
+	const double radius2 = radius * radius;
+
+	stats["node_accesses"] = 0;
+	stats["leaf_accesses"] = 0;
+	stats["results"] = 0;
+
+	// Root is a data object?
+	if (height == 1 && root.getMbr().distance2(query) <= radius2) {
+		stats["results"]++;
+	}
+
+	traverse([&](const Entry<N>& entry, unsigned level) {
+			if (entry.getMbr().distance2(query) > radius2) {
+				return false;
+			}
+
+			if (level == height) {
+				stats["results"]++;
+				return false;
+			}
+
+			if (level == height - 1) {
+				stats["leaf_accesses"]++;
+			}
+
+			stats["node_accesses"]++;
+			return true;
+		});
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::knnSearch(
+		StatsCollector& stats,
+		unsigned k,
+		const Point& point
+	) const
+{
+	Results results;
+	stats["node_accesses"] = 0;
+	stats["leaf_accesses"] = 0;
+	stats["max_queue_size"] = 0;
+
+	nearest(results, k, point, &stats);
+
+	stats["results"] = results.size();
+};
+
+
+template <class N, unsigned m>
+void Rtree<N, m>::nearest(
+		Results& results,
+		unsigned k,
+		const Point& point,
+		StatsCollector * stats
+	) const
+{
+	using QueueEntry = KnnQueueEntry<N>;
+
+	if (!k || !getHeight()) {
+		return;
+	}
+
+	const M query (point);
+
+	// Root is a data object?
+	if (getHeight() == 1) {
+		results.push_back(root.getId());
 		return;
 	}
 
-	for (auto e : root) {
-		deleteTree(e.getNode(), height - 1);
+	std::priority_queue<
+			QueueEntry,
+			std::vector<QueueEntry>,
+			std::greater<QueueEntry>
+		> queue;
+
+	// Distances of the k nearest objects queued so far
+	std::priority_queue<double> bound;
+
+	queue.emplace(
+			&root.getNode(),
+			getHeight() - 1,
+			root.getMbr().distance2(query)
+		);
+
+	while (!queue.empty()) {
+		const QueueEntry top = queue.top();
+		queue.pop();
+
+		// Objects come out nearest first
+		if (top.elevation == 0) {
+			results.push_back(top.id);
+
+			if (results.size() == k) {
+				return;
+			}
+
+			continue;
+		}
+
+		if (stats) {
+			(*stats)["node_accesses"]++;
+			(*stats)["leaf_accesses"] += top.elevation == 1;
+		}
+
+		for (const auto& entry : *top.node) {
+			double distance = entry.getMbr().distance2(query);
+
+			// Keep ties, as ids decide between equally distant objects
+			if (bound.size() == k && distance > bound.top()) {
+				continue;
+			}
+
+			if (top.elevation > 1) {
+				queue.emplace(&entry.getNode(), top.elevation - 1, distance);
+				continue;
+			}
+
+			queue.emplace(entry.getId(), 0, distance);
+
+			if (bound.size() == k) {
+				bound.pop();
+			}
+
+			bound.push(distance);
+		}
+
+		if (stats && queue.size() > (*stats)["max_queue_size"]) {
+			(*stats)["max_queue_size"] = queue.size();
+		}
+	}
+};
+
+
+template<class N, unsigned m>
+void Rtree<N, m>::deleteTree(N& root, unsigned height)
+{
+	// The children of leaves are data objects
+	if (height > 2) {
+		for (auto e : root) {
+			deleteTree(e.getNode(), height - 1);
+		}
 	}
 
-	delete &root;
+	destroyNode(&root);
 }
 
 }
@@ -0,0 +1,1079 @@
+#include <criterion/criterion.h>
+#include "QuadraticRtree.hpp"
+#include "BreadthFirstRtree.hpp"
+#include "DefaultNode.hpp"
+#include "AggregateEntryPlugin.hpp"
+#include "spatial/RangeQuery.hpp"
+#include "spatial/KnnQuery.hpp"
+#include "spatial/ContainsQuery.hpp"
+#include "spatial/WithinQuery.hpp"
+#include "spatial/StabbingQuery.hpp"
+#include "spatial/RadiusQuery.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <omp.h>
+
+using namespace Rtree;
+
+using Tree = QuadraticRtree<DefaultNode<2, 8>, 3>;
+using M = Mbr<2>;
+
+
+/**
+ * Use the id as payload, which gives exact sums.
+ */
+struct IdPayload
+{
+	unsigned long long operator()(const DataObject& object) const
+	{
+		return object.getId();
+	}
+};
+
+using AggregateTree = QuadraticRtree<
+		DefaultNode<2, 8, AggregateEntryPlugin<IdPayload>>,
+		3
+	>;
+
+
+/**
+ * Generate a grid of small, non-overlapping objects.
+ */
+std::vector<DataObject> generateObjects(unsigned n)
+{
+	std::vector<DataObject> objects;
+
+	for (unsigned i = 0; i < n; ++i) {
+		double x = i % 37;
+		double y = i / 37;
+
+		objects.emplace_back(
+				i + 1,
+				Box(Point {x, y}, Point {x + 0.5, y + 0.5})
+			);
+	}
+
+	return objects;
+}
+
+
+Test(Rtree, bulk_load_structure)
+{
+	for (unsigned n : {1u, 2u, 7u, 9u, 100u, 1000u}) {
+		Tree tree;
+		tree.bulkLoad(generateObjects(n));
+
+		try {
+			tree.checkStructure();
+		} catch (const InvalidStructureError& e) {
+			cr_assert_fail(
+					"Invalid structure after bulk loading %u objects: %s",
+					n, e.what()
+				);
+		}
+	}
+}
+
+
+Test(Rtree, bulk_load_height)
+{
+	Tree tree;
+	tree.bulkLoad(generateObjects(1000));
+
+	// 1000 -> 125 -> 16 -> 2 -> 1
+	cr_expect_eq(
+			tree.getHeight(),
+			5u,
+			"Full nodes should give a tree of height 5"
+		);
+}
+
+
+Test(Rtree, bulk_load_fill_factor)
+{
+	Tree full, half;
+	full.bulkLoad(generateObjects(1000));
+
+	half.setFillFactor(0.5);
+	half.bulkLoad(generateObjects(1000));
+
+	half.checkStructure();
+
+	cr_expect_gt(
+			half.collectStatistics()["nodes"],
+			full.collectStatistics()["nodes"],
+			"A lower fill factor should give more nodes"
+		);
+}
+
+
+Test(Rtree, bulk_load_search)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree;
+	tree.bulkLoad(objects);
+
+	for (unsigned i = 0; i < 20; ++i) {
+		Box box (
+				Point {1.7 * i, 1.3 * i},
+				Point {1.7 * i + 3.0, 1.3 * i + 5.0}
+			);
+
+		Results expected;
+
+		for (const DataObject& object : objects) {
+			if (object.getBox().intersects(box)) {
+				expected.push_back(object.getId());
+			}
+		}
+
+		Results results;
+		tree.search(results, RangeQuery(i, box));
+		std::sort(results.begin(), results.end());
+
+		cr_expect_eq(
+				results,
+				expected,
+				"Bulk loaded tree should give the same results as a scan"
+			);
+	}
+}
+
+
+Test(Rtree, parallel_bulk_load)
+{
+	// Enough objects to give each thread its own partition
+	auto objects = generateObjects(20000);
+
+	Tree serial, parallel;
+
+	omp_set_num_threads(1);
+	serial.bulkLoad(objects);
+
+	omp_set_num_threads(3);
+	parallel.bulkLoad(objects);
+
+	parallel.checkStructure();
+
+	Results all;
+	parallel.search(all, RangeQuery(0, Box(Point {0, 0}, Point {40, 600})));
+
+	cr_expect_eq(
+			all.size(),
+			objects.size(),
+			"All objects should be in the tree"
+		);
+
+	for (unsigned i = 0; i < 20; ++i) {
+		Box box (
+				Point {1.7 * i, 20.0 * i},
+				Point {1.7 * i + 3.0, 20.0 * i + 50.0}
+			);
+
+		Results expected, results;
+		serial.search(expected, RangeQuery(i, box));
+		parallel.search(results, RangeQuery(i, box));
+
+		std::sort(expected.begin(), expected.end());
+		std::sort(results.begin(), results.end());
+
+		cr_expect_eq(
+				results,
+				expected,
+				"Parallel bulk loading should give the same results"
+			);
+	}
+}
+
+
+Test(Rtree, search_sink)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree;
+	tree.bulkLoad(objects);
+
+	RangeQuery query (0, Box(Point {0, 0}, Point {20, 20}));
+
+	Results expected;
+	tree.search(expected, query);
+
+	CountingSink counter;
+	tree.search(counter, query);
+
+	cr_expect_eq(
+			counter.getCount(),
+			expected.size(),
+			"Counting should give the number of results"
+		);
+
+	// Stop after the first few results
+	std::vector<DataObject::Id> buffer (5);
+	BufferSink first (buffer.data(), buffer.size());
+	tree.search(first, query);
+
+	cr_expect(first.isStopped(), "Search should stop when buffer is full");
+	cr_expect_eq(first.getSize(), buffer.size(), "Buffer should be filled");
+	cr_expect(
+			std::equal(buffer.begin(), buffer.end(), expected.begin()),
+			"Early stop should give the first results"
+		);
+}
+
+
+Test(Rtree, search_batch)
+{
+	Tree tree;
+	tree.bulkLoad(generateObjects(1000));
+
+	// More than one batch, with early stops for some queries
+	std::vector<RangeQuery> queries;
+	std::vector<Results> results (100);
+	std::vector<std::vector<DataObject::Id>> buffers (100);
+	std::vector<std::unique_ptr<ResultSink>> sinks;
+
+	for (unsigned i = 0; i < 100; ++i) {
+		queries.emplace_back(i, Box(
+				Point {0.3 * i, 0.2 * i},
+				Point {0.3 * i + 3.0, 0.2 * i + 5.0}
+			));
+
+		if (i % 7) {
+			sinks.emplace_back(new VectorSink(results[i]));
+		} else {
+			buffers[i].resize(3);
+			sinks.emplace_back(new BufferSink(buffers[i].data(), 3));
+		}
+	}
+
+	std::vector<ResultSink *> pointers;
+
+	for (const auto& sink : sinks) {
+		pointers.push_back(sink.get());
+	}
+
+	tree.searchBatch(queries, pointers);
+
+	for (unsigned i = 0; i < 100; ++i) {
+		Results expected;
+		tree.search(expected, queries[i]);
+
+		if (i % 7 == 0) {
+			expected.resize(std::min<std::size_t>(expected.size(), 3));
+			results[i].assign(
+					buffers[i].begin(),
+					buffers[i].begin() + expected.size()
+				);
+		}
+
+		cr_expect_eq(
+				results[i],
+				expected,
+				"Batched search should match search of query %u",
+				i
+			);
+	}
+}
+
+
+Test(Rtree, predicate_search)
+{
+	// Overlapping objects of different sizes
+	std::vector<DataObject> objects;
+
+	for (unsigned i = 0; i < 1000; ++i) {
+		double x = i % 37;
+		double y = i / 37;
+		double size = 0.5 + i % 5;
+
+		objects.emplace_back(
+				i + 1,
+				Box(Point {x, y}, Point {x + size, y + size})
+			);
+	}
+
+	Tree tree;
+	tree.bulkLoad(objects);
+
+	std::size_t found = 0;
+
+	for (unsigned i = 0; i < 20; ++i) {
+		Point point {1.7 * i + 0.2, 1.3 * i + 0.1};
+		Box small (point, Point {point[0] + 0.5, point[1] + 0.5});
+		Box large (point, Point {point[0] + 4.0, point[1] + 6.0});
+
+		Results contains, within, stabbed;
+
+		for (const DataObject& object : objects) {
+			M mbr (object.getBox());
+
+			if (mbr.contains(M(small))) {
+				contains.push_back(object.getId());
+			}
+
+			if (M(large).contains(mbr)) {
+				within.push_back(object.getId());
+			}
+
+			if (object.getBox().contains(point)) {
+				stabbed.push_back(object.getId());
+			}
+		}
+
+		std::vector<std::pair<Results, std::unique_ptr<Query>>> cases;
+		cases.emplace_back(contains, std::unique_ptr<Query>(
+				new ContainsQuery(i, small)
+			));
+		cases.emplace_back(within, std::unique_ptr<Query>(
+				new WithinQuery(i, large)
+			));
+		cases.emplace_back(stabbed, std::unique_ptr<Query>(
+				new StabbingQuery(i, point)
+			));
+
+		for (const auto& c : cases) {
+			Results results;
+			tree.search(results, *c.second);
+			std::sort(results.begin(), results.end());
+
+			cr_expect_eq(
+					results,
+					c.first,
+					"Search for query %u should give the matching objects",
+					i
+				);
+
+			StatsCollector stats;
+			tree.search(stats, *c.second);
+
+			cr_expect_eq(
+					stats["results"],
+					c.first.size(),
+					"Stats should count the results"
+				);
+		}
+
+		found += std::min(contains.size(), within.size());
+	}
+
+	cr_expect_gt(found, 0u, "Queries should match some objects");
+}
+
+
+Test(Rtree, join)
+{
+	std::vector<DataObject> objects;
+
+	for (unsigned i = 0; i < 1000; ++i) {
+		double x = i % 37;
+		double y = i / 37;
+		double size = 0.5 + i % 3;
+
+		objects.emplace_back(
+				i + 1,
+				Box(Point {x, y}, Point {x + size, y + size})
+			);
+	}
+
+	Tree tree;
+	tree.bulkLoad(objects);
+
+	// Trees of different heights, down to a single object and none
+	for (unsigned n : {300u, 20u, 1u, 0u}) {
+		std::vector<DataObject> others;
+
+		for (unsigned i = 0; i < n; ++i) {
+			double x = 0.3 + (i * 7) % 36;
+			double y = 0.6 + (i * 3) % 27;
+
+			others.emplace_back(
+					i + 1,
+					Box(Point {x, y}, Point {x + 1.2, y + 0.2})
+				);
+		}
+
+		Tree other;
+
+		for (const DataObject& object : others) {
+			other.insert(object);
+		}
+
+		std::vector<PairSink::Pair> expected;
+
+		for (const DataObject& a : objects) {
+			for (const DataObject& b : others) {
+				if (a.getBox().intersects(b.getBox())) {
+					expected.emplace_back(a.getId(), b.getId());
+				}
+			}
+		}
+
+		std::vector<PairSink::Pair> pairs, reversed;
+		VectorPairSink sink (pairs);
+		VectorPairSink reversedSink (reversed);
+		tree.join(sink, other);
+		other.join(reversedSink, tree);
+
+		for (auto& pair : reversed) {
+			std::swap(pair.first, pair.second);
+		}
+
+		std::sort(expected.begin(), expected.end());
+		std::sort(pairs.begin(), pairs.end());
+		std::sort(reversed.begin(), reversed.end());
+
+		cr_expect(
+				pairs == expected,
+				"Join with %u objects should give all intersecting pairs",
+				n
+			);
+		cr_expect(
+				reversed == expected,
+				"Join should give the same pairs from the other tree"
+			);
+	}
+}
+
+
+Test(Rtree, parallel_join)
+{
+	auto objects = generateObjects(20000);
+	std::vector<DataObject> others;
+
+	// Dense in one corner, to give the tasks uneven work
+	for (unsigned i = 0; i < 5000; ++i) {
+		double x = i % 3 == 0 ? (i * 7) % 37 : (i * 7) % 5;
+		double y = i % 3 == 0 ? (i * 11) % 540 : (i * 11) % 20;
+
+		others.emplace_back(
+				i + 1,
+				Box(Point {x + 0.2, y + 0.3}, Point {x + 1.4, y + 0.6})
+			);
+	}
+
+	Tree tree, other;
+	tree.bulkLoad(objects);
+
+	for (const DataObject& object : others) {
+		other.insert(object);
+	}
+
+	std::vector<PairSink::Pair> expected, pairs;
+	VectorPairSink serialSink (expected);
+	VectorPairSink parallelSink (pairs);
+
+	omp_set_num_threads(1);
+	tree.join(serialSink, other);
+
+	omp_set_num_threads(3);
+	tree.join(parallelSink, other);
+
+	std::sort(expected.begin(), expected.end());
+	std::sort(pairs.begin(), pairs.end());
+
+	cr_expect_gt(expected.size(), others.size(), "Objects should overlap");
+	cr_expect(
+			pairs == expected,
+			"Parallel join should give the same pairs as a serial join"
+		);
+
+	// Stopping early
+	std::vector<PairSink::Pair> buffer (10);
+
+	class StoppingSink : public PairSink
+	{
+		public:
+			StoppingSink(Pair * buffer) : PairSink(buffer, 10) {}
+
+		protected:
+			bool flush(const Pair *, const Pair *) override
+			{
+				return false;
+			}
+	} stopping (buffer.data());
+
+	tree.join(stopping, other);
+	cr_expect(stopping.isStopped(), "Join should stop when asked to");
+}
+
+
+Test(Rtree, radius_search)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree;
+	tree.bulkLoad(objects);
+
+	for (unsigned i = 0; i < 20; ++i) {
+		Point point {1.9 * i, 1.3 * i};
+		Box box (point, Point {point[0] + 0.3 * (i % 4), point[1] + 1.0});
+		double radius = 0.25 * i;
+
+		Results expected;
+
+		for (const DataObject& object : objects) {
+			if (M(object.getBox()).distance2(M(box)) <= radius * radius) {
+				expected.push_back(object.getId());
+			}
+		}
+
+		Results results;
+		tree.search(results, RadiusQuery(i, box, radius));
+		std::sort(results.begin(), results.end());
+
+		cr_expect_eq(
+				results,
+				expected,
+				"Radius search %u should give the objects within the radius",
+				i
+			);
+
+		StatsCollector stats;
+		tree.search(stats, RadiusQuery(i, box, radius));
+
+		cr_expect_eq(
+				stats["results"],
+				expected.size(),
+				"Stats should count the results"
+			);
+	}
+
+	cr_expect_throw(
+			RadiusQuery(0, Point {0.0, 0.0}, -1.0),
+			std::invalid_argument,
+			"Negative radius should not be accepted"
+		);
+}
+
+
+Test(Rtree, nested_search)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree;
+	tree.setPrefetch(2, 1);
+	tree.bulkLoad(objects);
+
+	// Searches started by the sink of another search
+	class NestedSink : public ResultSink
+	{
+		public:
+			NestedSink(const Tree& tree, const std::vector<DataObject>& objects)
+				: ResultSink(chunk, 1), tree(tree), objects(objects) {}
+
+			unsigned long long count = 0;
+
+		protected:
+			bool flush(const Id * first, const Id * last) override
+			{
+				for (; first != last; ++first) {
+					const Box& box = objects[*first - 1].getBox();
+					Results results;
+
+					tree.search(results, RadiusQuery(0, box, 1.0));
+					tree.search(results, WithinQuery(0, box));
+					count += results.size();
+				}
+
+				return true;
+			}
+
+		private:
+			const Tree& tree;
+			const std::vector<DataObject>& objects;
+			Id chunk[1];
+	};
+
+	const Box box (Point {3.0, 3.0}, Point {6.0, 9.0});
+	unsigned long long expected = 0;
+	Results outer;
+	tree.search(outer, RadiusQuery(0, box, 2.0));
+
+	for (DataObject::Id id : outer) {
+		const Box& inner = objects[id - 1].getBox();
+		Results results;
+
+		tree.search(results, RadiusQuery(0, inner, 1.0));
+		tree.search(results, WithinQuery(0, inner));
+		expected += results.size();
+	}
+
+	NestedSink nested (tree, objects);
+	tree.search(nested, RadiusQuery(0, box, 2.0));
+
+	cr_expect_gt(outer.size(), 1u, "Query should match several objects");
+	cr_expect_eq(
+			nested.count,
+			expected,
+			"Searches within a search should not disturb each other"
+		);
+}
+
+
+Test(Rtree, distance_join)
+{
+	auto objects = generateObjects(1000);
+	std::vector<DataObject> others;
+
+	for (unsigned i = 0; i < 400; ++i) {
+		double x = 0.3 + (i * 7) % 36;
+		double y = 0.6 + (i * 3) % 27;
+
+		others.emplace_back(
+				i + 1,
+				Box(Point {x, y}, Point {x + 0.1, y + 0.1})
+			);
+	}
+
+	Tree tree, other;
+	tree.bulkLoad(objects);
+
+	for (const DataObject& object : others) {
+		other.insert(object);
+	}
+
+	for (double distance : {0.0, 0.2, 0.7, 2.5}) {
+		std::vector<PairSink::Pair> expected;
+
+		for (const DataObject& a : objects) {
+			for (const DataObject& b : others) {
+				const double d2 = M(a.getBox()).distance2(M(b.getBox()));
+
+				if (d2 <= distance * distance) {
+					expected.emplace_back(a.getId(), b.getId());
+				}
+			}
+		}
+
+		std::vector<PairSink::Pair> serial, parallel;
+		VectorPairSink serialSink (serial);
+		VectorPairSink parallelSink (parallel);
+
+		omp_set_num_threads(1);
+		tree.join(serialSink, other, distance);
+
+		omp_set_num_threads(3);
+		tree.join(parallelSink, other, distance);
+
+		std::sort(expected.begin(), expected.end());
+		std::sort(serial.begin(), serial.end());
+		std::sort(parallel.begin(), parallel.end());
+
+		cr_expect(
+				serial == expected,
+				"Join within %f should give all pairs within the distance",
+				distance
+			);
+		cr_expect(
+				parallel == expected,
+				"Parallel join within %f should give the same pairs",
+				distance
+			);
+	}
+
+	std::vector<PairSink::Pair> pairs;
+	VectorPairSink sink (pairs);
+
+	cr_expect_throw(
+			tree.join(sink, other, -1.0),
+			std::invalid_argument,
+			"Negative distance should not be accepted"
+		);
+}
+
+Test(Rtree, knn_search)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree;
+	tree.bulkLoad(objects);
+
+	for (unsigned i = 0; i < 20; ++i) {
+		Point point {1.9 * i, 1.3 * i};
+		M query (point);
+
+		// The grid has many objects at the same distance, which may come in
+		// any order, as the distances may be rounded differently by the tree
+		std::vector<double> distances;
+
+		for (const DataObject& object : objects) {
+			distances.push_back(M(object.getBox()).distance2(query));
+		}
+
+		std::vector<double> sorted (distances);
+		std::sort(sorted.begin(), sorted.end());
+
+		for (unsigned k : {1u, 7u, 50u}) {
+			Results results;
+			tree.search(results, KnnQuery(k, point));
+
+			cr_assert_eq(results.size(), k, "k-NN search should give k objects");
+
+			Results unique (results);
+			std::sort(unique.begin(), unique.end());
+
+			cr_expect(
+					std::unique(unique.begin(), unique.end()) == unique.end(),
+					"k-NN search should give each object once"
+				);
+
+			for (unsigned j = 0; j < k; ++j) {
+				cr_expect_leq(
+						std::abs(distances[results[j] - 1] - sorted[j]),
+						1e-9 * (1.0 + sorted[j]),
+						"k-NN search should give the nearest objects, nearest first"
+					);
+			}
+		}
+	}
+
+	StatsCollector stats;
+	tree.search(stats, KnnQuery(5, Point {10, 10}));
+
+	cr_expect_eq(stats["results"], 5u, "Stats should count the results");
+	cr_expect_lt(
+			stats["node_accesses"],
+			tree.collectStatistics()["nodes"],
+			"k-NN search should not visit every node"
+		);
+}
+
+
+Test(Rtree, count)
+{
+	auto objects = generateObjects(1000);
+
+	Tree plain;
+	AggregateTree loaded, inserted;
+
+	plain.bulkLoad(objects);
+	loaded.bulkLoad(objects);
+
+	for (const DataObject& object : objects) {
+		inserted.insert(object);
+	}
+
+	// Remove and move some objects, which must keep the counts
+	for (unsigned i = 0; i < objects.size(); i += 3) {
+		inserted.remove(objects[i]);
+	}
+
+	for (unsigned i = 1; i < objects.size(); i += 3) {
+		Box box (Point {40.0 + i % 7, 0.0}, Point {40.5 + i % 7, 0.5});
+		inserted.update(objects[i].getId(), objects[i].getBox(), box);
+	}
+
+	// From empty and single boxes to the complete data set
+	for (unsigned i = 0; i < 20; ++i) {
+		Box box (
+				Point {2.1 * i - 2.0, 1.3 * i},
+				Point {2.1 * i + 0.3 * i * i, 1.3 * i + 0.4 * i * i}
+			);
+
+		for (AggregateTree * tree : {&loaded, &inserted}) {
+			Results results;
+			tree->search(results, RangeQuery(i, box));
+
+			unsigned long long sum = 0;
+
+			for (DataObject::Id id : results) {
+				sum += id;
+			}
+
+			cr_expect_eq(
+					tree->count(box),
+					results.size(),
+					"Count should give the number of results"
+				);
+			cr_expect_eq(
+					tree->sum(box),
+					sum,
+					"Sum should add the payload of the results"
+				);
+		}
+
+		Results results;
+		plain.search(results, RangeQuery(i, box));
+
+		cr_expect_eq(
+				plain.count(box),
+				results.size(),
+				"Count should work without subtree counts"
+			);
+	}
+}
+
+
+Test(Rtree, remove)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree;
+
+	for (const DataObject& object : objects) {
+		tree.insert(object);
+	}
+
+	// Remove every other object, then the rest
+	for (unsigned start : {0u, 1u}) {
+		for (unsigned i = start; i < objects.size(); i += 2) {
+			cr_expect(tree.remove(objects[i]), "Object should be removed");
+		}
+
+		tree.checkStructure();
+	}
+
+	cr_expect_eq(tree.getHeight(), 0u, "Tree should be empty");
+	cr_expect_not(
+			tree.remove(objects[0]),
+			"Removed object should not be found"
+		);
+}
+
+
+Test(Rtree, remove_search)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree;
+	tree.bulkLoad(objects);
+
+	// Remove objects in a band through the middle of the grid
+	std::vector<DataObject> remaining;
+
+	for (const DataObject& object : objects) {
+		if (object.getId() % 37 > 10 && object.getId() % 37 < 20) {
+			tree.remove(object);
+		} else {
+			remaining.push_back(object);
+		}
+	}
+
+	tree.checkStructure();
+
+	for (unsigned i = 0; i < 20; ++i) {
+		Box box (
+				Point {1.7 * i, 1.3 * i},
+				Point {1.7 * i + 3.0, 1.3 * i + 5.0}
+			);
+
+		Results expected;
+
+		for (const DataObject& object : remaining) {
+			if (object.getBox().intersects(box)) {
+				expected.push_back(object.getId());
+			}
+		}
+
+		Results results;
+		tree.search(results, RangeQuery(i, box));
+		std::sort(results.begin(), results.end());
+
+		cr_expect_eq(
+				results,
+				expected,
+				"Removed objects should not be found"
+			);
+	}
+}
+
+
+Test(Rtree, update)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree;
+	tree.bulkLoad(objects);
+
+	// Move objects both a little and across the data set
+	for (unsigned i = 0; i < objects.size(); ++i) {
+		double shift = i % 5 ? 0.2 : 17.0;
+		Point bottom = objects[i].getBox().getPoints().first;
+		bottom[0] = std::fmod(bottom[0] + shift, 37.0);
+
+		Box box (bottom, Point {bottom[0] + 0.5, bottom[1] + 0.5});
+
+		cr_expect(
+				tree.update(objects[i].getId(), objects[i].getBox(), box),
+				"Object should be updated"
+			);
+
+		objects[i] = DataObject(objects[i].getId(), box);
+	}
+
+	tree.checkStructure();
+
+	for (const DataObject& object : objects) {
+		Results results;
+		tree.search(results, RangeQuery(0, object.getBox()));
+
+		cr_expect(
+				std::find(results.begin(), results.end(), object.getId())
+					!= results.end(),
+				"Object should be found at its new position"
+			);
+	}
+
+	Box original (Point {0, 0}, Point {0.5, 0.5});
+
+	cr_expect_not(
+			tree.update(1, original, objects[0].getBox()),
+			"Object should not be found at its old position"
+		);
+}
+
+
+Test(Rtree, prefetch)
+{
+	auto objects = generateObjects(1000);
+
+	Tree tree;
+	tree.setPrefetch(3, 100);
+	tree.bulkLoad(objects);
+
+	for (unsigned i = 0; i < 20; ++i) {
+		Box box (
+				Point {1.7 * i, 1.3 * i},
+				Point {1.7 * i + 3.0, 1.3 * i + 5.0}
+			);
+		double radius = 0.25 * i;
+
+		Results expected, near;
+
+		for (const DataObject& object : objects) {
+			if (object.getBox().intersects(box)) {
+				expected.push_back(object.getId());
+			}
+
+			if (M(object.getBox()).distance2(M(box)) <= radius * radius) {
+				near.push_back(object.getId());
+			}
+		}
+
+		Results results;
+		tree.search(results, RangeQuery(i, box));
+		std::sort(results.begin(), results.end());
+
+		cr_expect_eq(results, expected, "Prefetching should not change results");
+
+		results.clear();
+		tree.search(results, RadiusQuery(i, box, radius));
+		std::sort(results.begin(), results.end());
+
+		cr_expect_eq(results, near, "Prefetching should not change results");
+	}
+}
+
+
+Test(Rtree, breadth_first)
+{
+	auto objects = generateObjects(1000);
+
+	Tree inserted, loaded;
+	BreadthFirstRtree<Tree> levelInserted, levelLoaded;
+
+	for (const DataObject& object : objects) {
+		inserted.insert(object);
+		levelInserted.insert(object);
+	}
+
+	loaded.bulkLoad(objects);
+	levelLoaded.bulkLoad(objects);
+
+	std::pair<Tree *, Tree *> pairs[] = {
+			{&inserted, &levelInserted},
+			{&loaded, &levelLoaded}
+		};
+
+	for (const auto& trees : pairs) {
+		for (unsigned i = 0; i < 20; ++i) {
+			Point point {1.7 * i + 0.2, 1.3 * i + 0.1};
+			Box small (point, Point {point[0] + 0.5, point[1] + 0.5});
+			Box large (point, Point {point[0] + 4.0, point[1] + 6.0});
+
+			std::vector<std::unique_ptr<Query>> queries;
+			queries.emplace_back(new RangeQuery(i, large));
+			queries.emplace_back(new ContainsQuery(i, small));
+			queries.emplace_back(new WithinQuery(i, large));
+			queries.emplace_back(new StabbingQuery(i, point));
+
+			for (const auto& query : queries) {
+				Results expected, results;
+
+				trees.first->search(expected, *query);
+				std::sort(expected.begin(), expected.end());
+
+				trees.second->setPrefetch(i % 3, 2);
+				trees.second->search(results, *query);
+				std::sort(results.begin(), results.end());
+
+				cr_expect_eq(
+						results,
+						expected,
+						"Both traversals should give the same objects"
+					);
+			}
+		}
+	}
+
+	// Stop after the first few results
+	RangeQuery query (0, Box(Point {0, 0}, Point {20, 20}));
+
+	Results expected;
+	levelLoaded.search(expected, query);
+	std::sort(expected.begin(), expected.end());
+
+	std::vector<DataObject::Id> buffer (5);
+	BufferSink first (buffer.data(), buffer.size());
+	levelLoaded.search(first, query);
+
+	cr_expect(first.isStopped(), "Search should stop when buffer is full");
+
+	for (DataObject::Id id : buffer) {
+		cr_expect(
+				std::binary_search(expected.begin(), expected.end(), id),
+				"Early stop should give matching objects"
+			);
+	}
+}
+
+
+Test(Rtree, concurrent_search)
+{
+	Tree tree;
+	tree.bulkLoad(generateObjects(10000));
+
+	std::vector<Box> boxes;
+
+	for (unsigned i = 0; i < 200; ++i) {
+		boxes.emplace_back(
+				Point {0.17 * i, 1.3 * i},
+				Point {0.17 * i + 3.0, 1.3 * i + 5.0}
+			);
+	}
+
+	std::vector<Results> expected (boxes.size());
+
+	for (unsigned i = 0; i < boxes.size(); ++i) {
+		tree.search(expected[i], RangeQuery(i, boxes[i]));
+	}
+
+	std::vector<Results> results (boxes.size());
+	omp_set_num_threads(4);
+
+#	pragma omp parallel for schedule(dynamic, 1)
+	for (unsigned i = 0; i < boxes.size(); ++i) {
+		for (unsigned run = 0; run < 10; ++run) {
+			results[i].clear();
+			tree.search(results[i], RangeQuery(i, boxes[i]));
+		}
+	}
+
+	cr_expect(
+			results == expected,
+			"Concurrent searches should give the same results"
+		);
+}
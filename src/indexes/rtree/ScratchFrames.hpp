@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+
+namespace Rtree
+{
+
+	/**
+	 * Frames of the traversal stack of a search, borrowed from the thread.
+	 *
+	 * Each thread keeps the frames of its last search, such that searches
+	 * allocate nothing once the tree has stopped growing, while concurrent
+	 * searches still get frames of their own. A search started from within
+	 * another one (e.g. by its result sink) finds the thread's frames taken
+	 * and allocates its own.
+	 *
+	 * @tparam F Frame
+	 */
+	template<class F>
+	class ScratchFrames
+	{
+		public:
+			/**
+			 * Borrow the frames of this thread.
+			 *
+			 * @param size Number of frames needed
+			 */
+			explicit ScratchFrames(std::size_t size)
+			{
+				frames.swap(pool());
+
+				if (frames.size() < size) {
+					frames.resize(size);
+				}
+			}
+
+
+			/**
+			 * Hand the frames back to this thread.
+			 */
+			~ScratchFrames()
+			{
+				pool().swap(frames);
+			}
+
+
+			ScratchFrames(const ScratchFrames&) = delete;
+			ScratchFrames& operator=(const ScratchFrames&) = delete;
+
+
+			F& operator[](std::size_t i)
+			{
+				return frames[i];
+			}
+
+		private:
+			std::vector<F> frames;
+
+
+			/**
+			 * Get the frames kept by this thread.
+			 */
+			static std::vector<F>& pool()
+			{
+				static thread_local std::vector<F> frames;
+				return frames;
+			}
+	};
+
+}
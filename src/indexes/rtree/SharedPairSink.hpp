@@ -0,0 +1,45 @@
+#pragma once
+#include "spatial/PairSink.hpp"
+
+namespace Rtree
+{
+
+using Spatial::PairSink;
+
+/**
+ * Thread-local buffer in front of a pair sink shared by several threads.
+ *
+ * Each thread pushes its pairs into its own buffer, and only takes a lock
+ * when a full chunk is handed on to the shared sink. Once the shared sink
+ * has asked to stop, every buffer stops at its next flush.
+ */
+class SharedPairSink : public PairSink
+{
+	public:
+		/**
+		 * @param sink Shared sink receiving the pairs
+		 */
+		SharedPairSink(PairSink& sink)
+			: PairSink(chunk, CHUNK_SIZE), sink(sink)
+		{
+		}
+
+	protected:
+		bool flush(const Pair * first, const Pair * last) override
+		{
+			bool more;
+
+#			ifdef _OPENMP
+#			pragma omp critical(SharedPairSink)
+#			endif
+			more = sink.append(first, last);
+
+			return more;
+		}
+
+	private:
+		PairSink& sink;
+		Pair chunk[CHUNK_SIZE];
+};
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+
+namespace Rtree
+{
+
+	/**
+	 * Order in which the searches of an R-tree visit its nodes.
+	 */
+	enum class Traversal
+	{
+		/** Descend into each matching node as soon as it is found */
+		DEPTH_FIRST,
+
+		/**
+		 * Scan all matching nodes of a level before moving on to the next,
+		 * in the order of their addresses
+		 */
+		BREADTH_FIRST
+	};
+
+}
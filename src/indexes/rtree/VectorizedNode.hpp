@@ -1,6 +1,9 @@
 #pragma once
 #include "BaseNode.hpp"
+#include "PluginArray.hpp"
+#include "ProxyScanIterator.hpp"
 #include "spatial/Coordinate.hpp"
+#include "spatial/Lanes.hpp"
 #include "immintrin.h"
 #include <bitset>
 
@@ -11,14 +14,22 @@ namespace Rtree
 	 * Represents a vectorized node where an arrays of subfields approach has
 	 * been combined with vectorized scans (and full node scans).
 	 *
+	 * The entries are kept in blocks as wide as the vectors, such that each
+	 * block is compared with a single instruction per bottom and top. Use the
+	 * `VectorizedNode` (AVX2, or picked at runtime when the build does not
+	 * target it) and `VectorizedNode512` (AVX-512) aliases to pick the
+	 * vectors.
+	 *
 	 * @tparam D Dimension
 	 * @tparam C Max capacity
 	 * @tparam P Plugin
+	 * @tparam L Vector kernels (e.g. Spatial::Avx2Lanes)
 	 */
-	template<unsigned D, unsigned C, class P = EntryPlugin>
-	class VectorizedNode : public BaseNode<VectorizedNode<D, C, P>, C, P>
+	template<unsigned D, unsigned C, class P, class L>
+	class BasicVectorizedNode
+		: public BaseNode<BasicVectorizedNode<D, C, P, L>, C, P>
 	{
-		using Base = BaseNode<VectorizedNode<D, C, P>, C, P>;
+		using Base = BaseNode<BasicVectorizedNode<D, C, P, L>, C, P>;
 		using Coordinate = Spatial::Coordinate;
 
 
@@ -27,13 +38,13 @@ namespace Rtree
 				"Vector node assumes doubles"
 			);
 
-		static constexpr unsigned BLOCK_SIZE = 4;
+		static constexpr unsigned BLOCK_SIZE = L::WIDTH;
 		static constexpr unsigned N_BLOCKS = (C + BLOCK_SIZE - 1) / BLOCK_SIZE;
 
 
 		public:
 			using Mbr = ::Rtree::Mbr<D>;
-			using Link = ::Rtree::Link<VectorizedNode>;
+			using Link = ::Rtree::Link<BasicVectorizedNode>;
 			using Plugin = P;
 
 			// Inherit constructor and operator=
@@ -44,19 +55,20 @@ namespace Rtree
 			using Base::getSize;
 
 
-			class ScanIterator : public ProxyScanIterator<VectorizedNode>
+			class ScanIterator : public ProxyScanIterator<BasicVectorizedNode>
 			{
-				using Base = ProxyScanIterator<VectorizedNode>;
+				using Base = ProxyScanIterator<BasicVectorizedNode>;
 				using Base::entry;
 
 				public:
 					ScanIterator() = default;
 
 					ScanIterator(
-							const VectorizedNode * node,
+							const BasicVectorizedNode * node,
 							const Mbr& mbr,
-							unsigned index
-						) : Base(node, index), mbr(&mbr)
+							unsigned index,
+							Predicate predicate = Predicate::INTERSECTS
+						) : Base(node, index), mbr(&mbr), predicate(predicate)
 					{
 						if (index < node->getSize()) {
 							bitset = scanBlock();
@@ -83,6 +95,7 @@ namespace Rtree
 
 				private:
 					const Mbr * mbr;
+					Predicate predicate;
 					unsigned short bitset;
 
 
@@ -115,7 +128,7 @@ namespace Rtree
 					void findNext()
 					{
 						unsigned& index = entry.index;
-						const VectorizedNode * node = entry.node;
+						const BasicVectorizedNode * node = entry.node;
 
 						while (!(bitset & 1) && index < node->getSize()) {
 							next();
@@ -128,38 +141,55 @@ namespace Rtree
 					 */
 					unsigned short scanBlock() const
 					{
-						const unsigned& index = entry.index;
-						const VectorizedNode * node = entry.node;
-
 						auto highs = mbr->getTop();
 						auto lows = mbr->getBottom();
-						unsigned block = index / BLOCK_SIZE;
-						unsigned short bitset = (1 << BLOCK_SIZE) - 1;
-						const double * base = reinterpret_cast<const double*>(
-								node->coordinates + 2 * D * block
-							);
-
-						// Compare across all dimensions
-						for (unsigned j = 0; j < D; ++j) {
-
-							// Load bottom and top for query box
-							__m256d bottom = _mm256_broadcast_sd(&lows[j]);
-							__m256d top = _mm256_broadcast_sd(&highs[j]);
-
-							// Load bottom and top for subject
-							__m256d sbottom = _mm256_load_pd(base);
-							__m256d stop = _mm256_load_pd(base + BLOCK_SIZE);
-
-							bitset &= _mm256_movemask_pd(
-									_mm256_cmp_pd(top, sbottom, _CMP_GE_OS)
-								) & _mm256_movemask_pd(
-									_mm256_cmp_pd(stop, bottom, _CMP_GE_OS)
-								);
 
-							base += 2 * BLOCK_SIZE;
+						switch (predicate) {
+							case Predicate::CONTAINS:
+								return scanBlock<_CMP_LE_OS, _CMP_GE_OS>(
+										lows, highs
+									);
+
+							case Predicate::WITHIN:
+								return scanBlock<_CMP_GE_OS, _CMP_LE_OS>(
+										lows, highs
+									);
+
+							default:
+								return scanBlock<_CMP_LE_OS, _CMP_GE_OS>(
+										highs, lows
+									);
 						}
+					}
+
 
-						return bitset;
+					/**
+					 * Compare the bottoms and tops in the current block
+					 * against a reference value for each dimension.
+					 *
+					 * @tparam BOTTOM_OP Compare operation for the bottoms
+					 * @tparam TOP_OP Compare operation for the tops
+					 *
+					 * @param bottoms Reference values for the bottoms
+					 * @param tops Reference values for the tops
+					 * @return Bitset of entries passing all comparisons
+					 */
+					template<int BOTTOM_OP, int TOP_OP>
+					unsigned short scanBlock(
+							const double * bottoms,
+							const double * tops
+						) const
+					{
+						const unsigned& index = entry.index;
+						const BasicVectorizedNode * node = entry.node;
+
+						return L::template block<BOTTOM_OP, TOP_OP>(
+								node->block(index / BLOCK_SIZE),
+								BLOCK_SIZE,
+								D,
+								bottoms,
+								tops
+							);
 					}
 			};
 
@@ -172,23 +202,114 @@ namespace Rtree
 			template<class E>
 			std::pair<ScanIterator, ScanIterator> scan(
 					const Mbr& mbr,
-					const E&
+					const E&,
+					Predicate predicate = Predicate::INTERSECTS
 				) const
 			{
 				return std::make_pair(
-						ScanIterator(this, mbr, 0),
+						ScanIterator(this, mbr, 0, predicate),
 						ScanIterator(this, mbr, getSize())
 					);
 			}
 
 
+			/**
+			 * Test a batch of queries against every entry in this node.
+			 *
+			 * Each block is compared against all the queries while it is in
+			 * cache, a vector of entries at a time.
+			 *
+			 * @see BaseNode::scanBatch
+			 */
+			template<class E>
+			void scanBatch(
+					const Mbr * queries,
+					std::uint64_t active,
+					std::uint64_t * masks,
+					const E&
+				) const
+			{
+				for (unsigned block = 0; block < N_BLOCKS; ++block) {
+					const unsigned first = block * BLOCK_SIZE;
+
+					if (first >= getSize()) {
+						break;
+					}
+
+					const double * base = this->block(block);
+					std::uint64_t lanes[BLOCK_SIZE] = {};
+
+					for (std::uint64_t rest = active; rest; rest &= rest - 1) {
+						unsigned q = __builtin_ctzll(rest);
+
+						unsigned bitset = L::template block<_CMP_LE_OS, _CMP_GE_OS>(
+								base,
+								BLOCK_SIZE,
+								D,
+								queries[q].getTop(),
+								queries[q].getBottom()
+							);
+
+						for (; bitset; bitset &= bitset - 1) {
+							lanes[__builtin_ctz(bitset)] |= std::uint64_t(1) << q;
+						}
+					}
+
+					const unsigned n = std::min(
+							getSize() - first,
+							unsigned(BLOCK_SIZE)
+						);
+					std::copy(lanes, lanes + n, masks + first);
+				}
+			}
+
+
+			/**
+			 * Calculate the squared distance from an MBR to every entry in
+			 * this node.
+			 *
+			 * The distance along each dimension is found for a vector of
+			 * entries at a time, as the gap between the bottoms and tops in
+			 * the block.
+			 *
+			 * @see BaseNode::scanDistance
+			 */
+			void scanDistance(const Mbr& mbr, double * distances) const
+			{
+				for (unsigned block = 0; block < N_BLOCKS; ++block) {
+					const unsigned first = block * BLOCK_SIZE;
+
+					if (first >= getSize()) {
+						break;
+					}
+
+					double lanes[BLOCK_SIZE];
+
+					L::distance(
+							this->block(block),
+							BLOCK_SIZE,
+							D,
+							mbr.getBottom(),
+							mbr.getTop(),
+							lanes
+						);
+
+					const unsigned n = std::min(
+							getSize() - first,
+							unsigned(BLOCK_SIZE)
+						);
+					std::copy(lanes, lanes + n, distances + first);
+				}
+			}
+
+
 			/**
 			 * Override new operator to make sure memory is aligned.
 			 */
 			void * operator new(std::size_t count)
 			{
 				void * p;
-				int error = posix_memalign(&p, sizeof(__m256d), count);
+				int error = posix_memalign(&p, alignof(BasicVectorizedNode), count);
 
 				// Convert C-style error to exception
 				if (error) {
@@ -196,7 +317,7 @@ namespace Rtree
 				}
 
 				//TODO: Remove
-				if (reinterpret_cast<uintptr_t>(p) % sizeof(__m256d) != 0) {
+				if (reinterpret_cast<uintptr_t>(p) % alignof(BasicVectorizedNode) != 0) {
 					throw std::runtime_error("Unaligned memory :-(");
 				}
 
@@ -248,9 +369,7 @@ namespace Rtree
 			{
 				std::array<Coordinate, D> bottom, top;
 
-				auto base = reinterpret_cast<const double *>(
-						coordinates + 2 * D * (index / BLOCK_SIZE)
-					) + index % BLOCK_SIZE;
+				auto base = block(index / BLOCK_SIZE) + index % BLOCK_SIZE;
 
 				for (unsigned d = 0; d < D; ++d) {
 					bottom[d] = base[0];
@@ -272,9 +391,9 @@ namespace Rtree
 				auto top = m.getTop();
 				auto bottom = m.getBottom();
 
-				auto base = reinterpret_cast<double *>(
-						coordinates + 2 * D * (index / BLOCK_SIZE)
-					) + index % BLOCK_SIZE;
+				auto base = coordinates
+					+ 2 * D * BLOCK_SIZE * (index / BLOCK_SIZE)
+					+ index % BLOCK_SIZE;
 
 				for (unsigned d = 0; d < D; ++d) {
 					base[0] = bottom[d];
@@ -307,9 +426,37 @@ namespace Rtree
 
 
 		private:
-			__m256d coordinates[N_BLOCKS * 2 * D];
+			/**
+			 * Get the first coordinate of a block of entries.
+			 */
+			const Coordinate * block(unsigned b) const
+			{
+				return coordinates + 2 * D * BLOCK_SIZE * b;
+			}
+
+
+			alignas(BLOCK_SIZE * sizeof(Coordinate))
+				Coordinate coordinates[N_BLOCKS * 2 * D * BLOCK_SIZE];
 			Link links[C];
-			Plugin plugins[C];
+			PluginArray<Plugin, C> plugins;
 	};
 
+
+	/**
+	 * Vectorized node comparing four entries at a time with AVX2, or blocks
+	 * of eight with the widest vectors found at runtime when the build does
+	 * not target AVX2.
+	 */
+	template<unsigned D, unsigned C, class P = EntryPlugin>
+	using VectorizedNode = BasicVectorizedNode<D, C, P, Spatial::DefaultLanes>;
+
+
+#ifdef __AVX512F__
+	/**
+	 * Vectorized node comparing eight entries at a time with AVX-512.
+	 */
+	template<unsigned D, unsigned C, class P = EntryPlugin>
+	using VectorizedNode512 = BasicVectorizedNode<D, C, P, Spatial::Avx512Lanes>;
+#endif
+
 }
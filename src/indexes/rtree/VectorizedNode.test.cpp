@@ -4,10 +4,43 @@
 Test(VectorizedNode, data_retainment)
 {
 	testRetainment<VectorizedNode>();
+#ifdef __AVX512F__
+	testRetainment<VectorizedNode512>();
+#endif
 }
 
 
 Test(VectorizedNode, scan)
 {
 	testScanning<VectorizedNode>();
+#ifdef __AVX512F__
+	testScanning<VectorizedNode512>();
+#endif
+}
+
+
+Test(VectorizedNode, scan_batch)
+{
+	testBatchScanning<VectorizedNode>();
+#ifdef __AVX512F__
+	testBatchScanning<VectorizedNode512>();
+#endif
+}
+
+
+Test(VectorizedNode, scan_predicates)
+{
+	testPredicateScanning<VectorizedNode>();
+#ifdef __AVX512F__
+	testPredicateScanning<VectorizedNode512>();
+#endif
+}
+
+
+Test(VectorizedNode, scan_distance)
+{
+	testDistanceScanning<VectorizedNode>();
+#ifdef __AVX512F__
+	testDistanceScanning<VectorizedNode512>();
+#endif
 }
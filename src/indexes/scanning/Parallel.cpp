@@ -1,35 +1,168 @@
 #include "Parallel.hpp"
+#include "spatial/NearestNeighbours.hpp"
+#include <omp.h>
+#include <vector>
 
 namespace Scanning
 {
 
-void Parallel::rangeSearch(Results& results, const Box& box) const
+void Parallel::rangeSearch(ResultSink& sink, const Box& box) const
+{
+	scan<Predicate::INTERSECTS>(sink, box);
+};
+
+
+void Parallel::predicateSearch(
+		ResultSink& sink,
+		const Box& box,
+		Predicate predicate
+	) const
+{
+	switch (predicate) {
+		case Predicate::CONTAINS:
+			return scan<Predicate::CONTAINS>(sink, box);
+
+		case Predicate::WITHIN:
+			return scan<Predicate::WITHIN>(sink, box);
+
+		default:
+			return scan<Predicate::INTERSECTS>(sink, box);
+	}
+};
+
+
+template<Predicate P>
+void Parallel::scan(ResultSink& sink, const Box& box) const
+{
+	const Point& bottom = box.getPoints().first;
+	const Point& top = box.getPoints().second;
+
+	std::vector<std::vector<DataObject::Id>> buffers (omp_get_max_threads());
+
+	// Scan through data, each thread collecting its own results
+#	pragma omp parallel num_threads(buffers.size())
+	{
+		std::vector<DataObject::Id> local;
+
+#		pragma omp for schedule(static)
+		for (unsigned i = 0; i < nObjects; i++) {
+			if (matches<P>(i, bottom, top)) {
+				local.push_back(ids[i]);
+			}
+		}
+
+		buffers[omp_get_thread_num()] = std::move(local);
+	}
+
+	// A static schedule gives each thread one consecutive chunk, in order
+	for (const auto& buffer : buffers) {
+		if (!sink.append(buffer.data(), buffer.data() + buffer.size())) {
+			return;
+		}
+	}
+};
+
+
+void Parallel::knnSearch(
+		Results& results,
+		unsigned k,
+		const Point& point
+	) const
+{
+	NearestNeighbours nearest (k);
+
+	// Each thread keeps its own candidates, merged once it is done
+#	pragma omp parallel
+	{
+		NearestNeighbours local (k);
+
+#		pragma omp for schedule(static) nowait
+		for (unsigned i = 0; i < nObjects; i++) {
+			local.offer(distance2(i, point), ids[i]);
+		}
+
+#		pragma omp critical
+		nearest.merge(local);
+	}
+
+	nearest.extract(results);
+};
+
+
+
+void Parallel::radiusSearch(
+		ResultSink& sink,
+		const Box& box,
+		double radius
+	) const
 {
 	const Point& bottom = box.getPoints().first;
 	const Point& top = box.getPoints().second;
+	const double radius2 = radius * radius;
+
+	std::vector<std::vector<DataObject::Id>> buffers (omp_get_max_threads());
 
-	// Scan through data
-#	pragma omp parallel for schedule(static)
-	for (unsigned i = 0; i < nObjects; i++) {
-		bool inside = true;
+#	pragma omp parallel num_threads(buffers.size())
+	{
+		std::vector<DataObject::Id> local;
 
-		for (unsigned j = 0; j < dimension; j++) {
-			const unsigned k = 2 * (dimension * i + j);
-			inside &= top[j] >= positions[k] && positions[k + 1] >= bottom[j];
+#		pragma omp for schedule(static)
+		for (unsigned i = 0; i < nObjects; i++) {
+			if (distance2(i, bottom, top) <= radius2) {
+				local.push_back(ids[i]);
+			}
 		}
 
-		if (inside) {
-			//TODO: Is this a bottleneck. Alternative: Combine sets after loop
-#			pragma omp critical
-			results.push_back(ids[i]);
+		buffers[omp_get_thread_num()] = std::move(local);
+	}
+
+	for (const auto& buffer : buffers) {
+		if (!sink.append(buffer.data(), buffer.data() + buffer.size())) {
+			return;
 		}
 	}
 };
 
 
-void Parallel::knnSearch(Results&, unsigned k, const Point& point) const
+void Parallel::distanceJoin(
+		PairSink& sink,
+		const SpatialIndex& other,
+		double distance
+	) const
 {
-	throw std::logic_error("Not implemented");
+	const Parallel * scan = dynamic_cast<const Parallel *>(&other);
+
+	if (scan == nullptr) {
+		SpatialIndex::distanceJoin(sink, other, distance);
+		return;
+	}
+
+	const double limit = distance * distance;
+
+	std::vector<std::vector<PairSink::Pair>> buffers (omp_get_max_threads());
+
+	// Each thread joins a consecutive chunk of this index's objects
+#	pragma omp parallel num_threads(buffers.size())
+	{
+		std::vector<PairSink::Pair> local;
+
+#		pragma omp for schedule(static)
+		for (unsigned i = 0; i < nObjects; i++) {
+			for (unsigned j = 0; j < scan->nObjects; j++) {
+				if (distance2(i, *scan, j) <= limit) {
+					local.emplace_back(ids[i], scan->ids[j]);
+				}
+			}
+		}
+
+		buffers[omp_get_thread_num()] = std::move(local);
+	}
+
+	for (const auto& buffer : buffers) {
+		if (!sink.append(buffer.data(), buffer.data() + buffer.size())) {
+			return;
+		}
+	}
 };
 
 }
@@ -15,8 +15,31 @@ class Parallel : public Scanning
 		using Scanning::Scanning;
 
 	protected:
-		void rangeSearch(Results& results, const Box& box) const;
+		void rangeSearch(ResultSink& sink, const Box& box) const;
+		void predicateSearch(
+				ResultSink& sink,
+				const Box& box,
+				Predicate predicate
+			) const;
 		void knnSearch(Results& results, unsigned k, const Point& point) const;
+		void radiusSearch(
+				ResultSink& sink,
+				const Box& box,
+				double radius
+			) const;
+
+		/**
+		 * Nested loop join, only with scans of the same type.
+		 */
+		void distanceJoin(
+				PairSink& sink,
+				const SpatialIndex& other,
+				double distance
+			) const;
+
+	private:
+		template<Predicate P>
+		void scan(ResultSink& sink, const Box& box) const;
 };
 
 }
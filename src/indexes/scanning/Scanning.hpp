@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include "spatial/Coordinate.hpp"
 #include "spatial/DataObject.hpp"
 #include "spatial/SpatialIndex.hpp"
@@ -25,6 +26,119 @@ class Scanning : public ::SpatialIndex
 		void insert(const DataObject& object) override;
 
 	protected:
+
+		/**
+		 * Calculate the squared distance between an object and a point.
+		 *
+		 * @param i Index of the object
+		 * @param point Point to measure from
+		 * @return Squared distance, 0 if the point is inside the object
+		 */
+		double distance2(unsigned i, const Point& point) const
+		{
+			double d = 0.0;
+
+			for (unsigned j = 0; j < dimension; j++) {
+				const unsigned k = 2 * (dimension * i + j);
+				double diff = std::max(
+						std::max(0.0, positions[k] - point[j]),
+						point[j] - positions[k + 1]
+					);
+
+				d += diff * diff;
+			}
+
+			return d;
+		}
+
+		/**
+		 * Calculate the squared distance between an object and a box.
+		 *
+		 * @param i Index of the object
+		 * @param bottom Bottom corner of the box
+		 * @param top Top corner of the box
+		 * @return Squared distance, 0 if they intersect
+		 */
+		double distance2(unsigned i, const Point& bottom, const Point& top) const
+		{
+			double d = 0.0;
+
+			for (unsigned j = 0; j < dimension; j++) {
+				const unsigned k = 2 * (dimension * i + j);
+				double diff = std::max(
+						std::max(0.0, positions[k] - top[j]),
+						bottom[j] - positions[k + 1]
+					);
+
+				d += diff * diff;
+			}
+
+			return d;
+		}
+
+		/**
+		 * Calculate the squared distance between objects of two indexes.
+		 *
+		 * @param i Index of the object in this
+		 * @param other Other index, of the same dimension
+		 * @param j Index of the object in other
+		 * @return Squared distance, 0 if they intersect
+		 */
+		double distance2(unsigned i, const Scanning& other, unsigned j) const
+		{
+			double d = 0.0;
+
+			for (unsigned l = 0; l < dimension; l++) {
+				const unsigned k = 2 * (dimension * i + l);
+				const unsigned o = 2 * (dimension * j + l);
+				double diff = std::max(
+						std::max(0.0, positions[k] - other.positions[o + 1]),
+						other.positions[o] - positions[k + 1]
+					);
+
+				d += diff * diff;
+			}
+
+			return d;
+		}
+
+		/**
+		 * Check whether an object relates to a box as given by a predicate.
+		 *
+		 * @tparam P Predicate
+		 * @param i Index of the object
+		 * @param bottom Bottom corner of the box
+		 * @param top Top corner of the box
+		 * @return True if the object matches
+		 */
+		template<Predicate P>
+		bool matches(unsigned i, const Point& bottom, const Point& top) const
+		{
+			bool match = true;
+
+			for (unsigned j = 0; j < dimension; j++) {
+				const unsigned k = 2 * (dimension * i + j);
+
+				switch (P) {
+					case Predicate::CONTAINS:
+						match &= positions[k] <= bottom[j]
+							&& top[j] <= positions[k + 1];
+						break;
+
+					case Predicate::WITHIN:
+						match &= bottom[j] <= positions[k]
+							&& positions[k + 1] <= top[j];
+						break;
+
+					default:
+						match &= top[j] >= positions[k]
+							&& positions[k + 1] >= bottom[j];
+				}
+			}
+
+			return match;
+		}
+
 		unsigned nObjects = 0;
 		unsigned dimension;
 		Coordinate * positions;
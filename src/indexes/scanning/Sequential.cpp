@@ -1,36 +1,111 @@
 #include "Sequential.hpp"
+#include "spatial/NearestNeighbours.hpp"
 #include <algorithm>
 #include <functional>
 
 namespace Scanning
 {
 
-void Sequential::rangeSearch(Results& results, const Box& box) const
+void Sequential::rangeSearch(ResultSink& sink, const Box& box) const
+{
+	scan<Predicate::INTERSECTS>(sink, box);
+};
+
+
+void Sequential::predicateSearch(
+		ResultSink& sink,
+		const Box& box,
+		Predicate predicate
+	) const
+{
+	switch (predicate) {
+		case Predicate::CONTAINS:
+			return scan<Predicate::CONTAINS>(sink, box);
+
+		case Predicate::WITHIN:
+			return scan<Predicate::WITHIN>(sink, box);
+
+		default:
+			return scan<Predicate::INTERSECTS>(sink, box);
+	}
+};
+
+
+template<Predicate P>
+void Sequential::scan(ResultSink& sink, const Box& box) const
 {
 	const Point& bottom = box.getPoints().first;
 	const Point& top = box.getPoints().second;
 
 	// Scan through data
 	for (unsigned i = 0; i < nObjects; i++) {
-		bool intersects = true;
-
-		for (unsigned j = 0; j < dimension; j++) {
-			const unsigned k = 2 * (dimension * i + j);
-			intersects &= (
-					top[j] >= positions[k] && positions[k + 1] >= bottom[j]
-				);
+		if (matches<P>(i, bottom, top) && !sink.push(ids[i])) {
+			return;
 		}
+	}
+};
+
+
+void Sequential::knnSearch(
+		Results& results,
+		unsigned k,
+		const Point& point
+	) const
+{
+	NearestNeighbours nearest (k);
+
+	for (unsigned i = 0; i < nObjects; i++) {
+		nearest.offer(distance2(i, point), ids[i]);
+	}
+
+	nearest.extract(results);
+};
+
+
+
+void Sequential::radiusSearch(
+		ResultSink& sink,
+		const Box& box,
+		double radius
+	) const
+{
+	const Point& bottom = box.getPoints().first;
+	const Point& top = box.getPoints().second;
+	const double radius2 = radius * radius;
 
-		if (intersects) {
-			results.push_back(ids[i]);
+	for (unsigned i = 0; i < nObjects; i++) {
+		if (distance2(i, bottom, top) <= radius2 && !sink.push(ids[i])) {
+			return;
 		}
 	}
 };
 
 
-void Sequential::knnSearch(Results&, unsigned k, const Point& point) const
+void Sequential::distanceJoin(
+		PairSink& sink,
+		const SpatialIndex& other,
+		double distance
+	) const
 {
-	throw std::logic_error("KNN search not implemented");
+	const Sequential * scan = dynamic_cast<const Sequential *>(&other);
+
+	if (scan == nullptr) {
+		SpatialIndex::distanceJoin(sink, other, distance);
+		return;
+	}
+
+	const double limit = distance * distance;
+
+	for (unsigned i = 0; i < nObjects; i++) {
+		for (unsigned j = 0; j < scan->nObjects; j++) {
+			if (
+					distance2(i, *scan, j) <= limit
+					&& !sink.push(ids[i], scan->ids[j])
+			) {
+				return;
+			}
+		}
+	}
 };
 
 }
@@ -14,8 +14,31 @@ class Sequential : public Scanning
 		using Scanning::Scanning;
 
 	protected:
-		void rangeSearch(Results& results, const Box& box) const override;
+		void rangeSearch(ResultSink& sink, const Box& box) const override;
+		void predicateSearch(
+				ResultSink& sink,
+				const Box& box,
+				Predicate predicate
+			) const override;
 		void knnSearch(Results& results, unsigned k, const Point& point) const override;
+		void radiusSearch(
+				ResultSink& sink,
+				const Box& box,
+				double radius
+			) const override;
+
+		/**
+		 * Nested loop join, only with scans of the same type.
+		 */
+		void distanceJoin(
+				PairSink& sink,
+				const SpatialIndex& other,
+				double distance
+			) const override;
+
+	private:
+		template<Predicate P>
+		void scan(ResultSink& sink, const Box& box) const;
 };
 
 }
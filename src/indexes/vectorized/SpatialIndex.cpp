@@ -1,15 +1,21 @@
 #include "SpatialIndex.hpp"
+#include "spatial/Lanes.hpp"
+#include "spatial/NearestNeighbours.hpp"
 #include <limits>
 #include <queue>
 #include <memory>
-#include "immintrin.h"
+#include <vector>
+#include <omp.h>
 #include "malloc.h"
 
 namespace Vectorized
 {
 
+// Kernels for the build target, picked at runtime if it does not target AVX2
+using Lanes = Spatial::DefaultLanes;
+
 // Number of items per block
-constexpr unsigned blockSize = sizeof(__m256) / sizeof(Coordinate);
+constexpr unsigned blockSize = Lanes::WIDTH;
 
 
 SpatialIndex::SpatialIndex(unsigned dimension, unsigned long long size)
@@ -20,8 +26,8 @@ SpatialIndex::SpatialIndex(unsigned dimension, unsigned long long size)
 
 	positions = reinterpret_cast<decltype(positions)>(
 			memalign(
-			sizeof(__m256),
-			2 * dimension * nBlocks * sizeof(__m256)
+			blockSize * sizeof(Coordinate),
+			2 * dimension * nBlocks * blockSize * sizeof(Coordinate)
 		));
 
 	ids = new DataObject::Id[size];
@@ -60,61 +66,143 @@ SpatialIndex::~SpatialIndex()
 };
 
 
-void SpatialIndex::rangeSearch(Results& results, const Box& box) const
+void SpatialIndex::rangeSearch(ResultSink& sink, const Box& box) const
 {
-	constexpr unsigned short mask = (1u << blockSize) - 1u;
-	const auto points = box.getPoints();
+	const auto& points = box.getPoints();
+
+	// Within reach if the bottom is below the query's top, and vice versa
+	scan<_CMP_LE_OS, _CMP_GE_OS>(sink, points.second, points.first);
+};
 
-#	pragma omp parallel for schedule(static)
-	for (unsigned b = 0; b < nBlocks; ++b) {
 
-		// Bit vector where a 1 means the object is outside
-		unsigned short outside = 0;
+void SpatialIndex::predicateSearch(
+		ResultSink& sink,
+		const Box& box,
+		Predicate predicate
+	) const
+{
+	const auto& points = box.getPoints();
+
+	switch (predicate) {
+		case Predicate::CONTAINS:
+			// Inside if the bottom is below the query's and the top above
+			return scan<_CMP_LE_OS, _CMP_GE_OS>(
+					sink, points.first, points.second
+				);
+
+		case Predicate::WITHIN:
+			// Inside if the bottom is above the query's and the top below
+			return scan<_CMP_GE_OS, _CMP_LE_OS>(
+					sink, points.first, points.second
+				);
+
+		default:
+			return rangeSearch(sink, box);
+	}
+};
 
-		// Compare across all dimensions
-		for (unsigned j = 0; j < dimension; ++j) {
 
-			// Skip if we know the result
-			if (!(~outside & mask)) {
-				break;
+template<int BOTTOM_OP, int TOP_OP>
+void SpatialIndex::scan(
+		ResultSink& sink,
+		const Point& bottoms,
+		const Point& tops
+	) const
+{
+	std::vector<std::vector<DataObject::Id>> buffers (omp_get_max_threads());
+
+	// Each thread collects its own results
+#	pragma omp parallel num_threads(buffers.size())
+	{
+		std::vector<DataObject::Id> local;
+
+#		pragma omp for schedule(static)
+		for (unsigned b = 0; b < nBlocks; ++b) {
+
+			// Bit vector where a 1 means the object matches
+			unsigned inside = Lanes::block<BOTTOM_OP, TOP_OP>(
+					positions + 2 * blockSize * b * dimension,
+					blockSize,
+					dimension,
+					&bottoms[0],
+					&tops[0]
+				);
+
+			// Skip the rest if none were within
+			if (!inside) {
+				continue;
 			}
 
-			// Load bottom and top for query box
-			__m256d bottom = _mm256_broadcast_sd(&points.first[j]);
-			__m256d top = _mm256_broadcast_sd(&points.second[j]);
+			// Push results
+			unsigned baseIndex = b * blockSize;
+			for (unsigned j = 0; j < blockSize; j++) {
+				unsigned index = baseIndex + j;
 
-			// Load bottom and top for subject
-			__m256d sbottom = _mm256_load_pd(positions + 2 * blockSize * (b * dimension + j));
-			__m256d stop = _mm256_load_pd(positions + 2 * blockSize * (b * dimension + j) + blockSize);
-
-			outside |= _mm256_movemask_pd(_mm256_cmp_pd(top, sbottom, _CMP_LT_OS)) |
-					_mm256_movemask_pd(_mm256_cmp_pd(stop, bottom, _CMP_LT_OS));
-		}
+				if (!((inside >> j) & 1) || index >= nObjects) {
+					continue;
+				}
 
-		// Skip the rest if none were within
-		if (!(~outside & mask)) {
-			continue;
+				local.push_back(ids[index]);
+			}
 		}
 
-		// Push results
-		unsigned baseIndex = b * blockSize;
-		for (unsigned j = 0; j < blockSize; j++) {
-			unsigned index = baseIndex + j;
-
-			if (((outside >> j) & 1) || index >= nObjects) {
-				continue;
-			}
+		buffers[omp_get_thread_num()] = std::move(local);
+	}
 
-#			pragma omp critical
-			results.push_back(ids[index]);
+	// A static schedule gives each thread one consecutive chunk, in order
+	for (const auto& buffer : buffers) {
+		if (!sink.append(buffer.data(), buffer.data() + buffer.size())) {
+			return;
 		}
 	}
 };
 
 
-void SpatialIndex::knnSearch(Results&, unsigned, const Point&) const
+void SpatialIndex::knnSearch(
+		Results& results,
+		unsigned k,
+		const Point& point
+	) const
 {
-	throw std::logic_error("KNN search not implemented");
+	NearestNeighbours nearest (k);
+
+	// Each thread keeps its own candidates, merged once it is done
+#	pragma omp parallel
+	{
+		NearestNeighbours local (k);
+		double distances[blockSize];
+
+#		pragma omp for schedule(static) nowait
+		for (unsigned b = 0; b < nBlocks; ++b) {
+
+			// Squared distance from point to each box in the block
+			Lanes::distance(
+					positions + 2 * blockSize * b * dimension,
+					blockSize,
+					dimension,
+					&point[0],
+					&point[0],
+					distances
+				);
+
+			unsigned baseIndex = b * blockSize;
+			for (unsigned j = 0; j < blockSize; j++) {
+				unsigned index = baseIndex + j;
+
+				// Skip objects too far away to be a candidate
+				if (distances[j] > local.bound() || index >= nObjects) {
+					continue;
+				}
+
+				local.offer(distances[j], ids[index]);
+			}
+		}
+
+#		pragma omp critical
+		nearest.merge(local);
+	}
+
+	nearest.extract(results);
 };
 
 }
@@ -24,10 +24,34 @@ class SpatialIndex : public ::SpatialIndex
 		void insert(const DataObject& object);
 
 	protected:
-		void rangeSearch(Results& results, const Box& box) const;
+		void rangeSearch(ResultSink& sink, const Box& box) const;
+		void predicateSearch(
+				ResultSink& sink,
+				const Box& box,
+				Predicate predicate
+			) const;
 		void knnSearch(Results& results, unsigned k, const Point& point) const;
 
 	private:
+
+		/**
+		 * Scan all blocks, comparing the bottoms and tops of the objects
+		 * against a reference value each.
+		 *
+		 * @tparam BOTTOM_OP Comparison of bottoms passing an object
+		 * @tparam TOP_OP Comparison of tops passing an object
+		 *
+		 * @param sink Sink receiving the matching objects
+		 * @param bottoms Reference values for the bottoms
+		 * @param tops Reference values for the tops
+		 */
+		template<int BOTTOM_OP, int TOP_OP>
+		void scan(
+				ResultSink& sink,
+				const Point& bottoms,
+				const Point& tops
+			) const;
+
 		unsigned nBlocks;
 		unsigned long long nObjects = 0;
 		unsigned dimension;
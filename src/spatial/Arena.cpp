@@ -0,0 +1,184 @@
+#include "Arena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+
+namespace Spatial
+{
+
+constexpr std::size_t Arena::CHUNK_SIZE;
+constexpr std::size_t Arena::LINE_SIZE;
+
+
+/**
+ * Round a size up to a multiple of another.
+ */
+static std::size_t roundUp(std::size_t size, std::size_t multiple)
+{
+	return (size + multiple - 1) / multiple * multiple;
+}
+
+
+Arena::Arena(std::size_t size, std::size_t alignment, Pages pages)
+	: pages(pages)
+{
+	if (alignment > CHUNK_SIZE || (alignment & (alignment - 1))) {
+		throw std::invalid_argument("Slot alignment must be a power of two");
+	}
+
+	// A released slot keeps a pointer to the next one
+	slotSize = roundUp(
+			std::max(size, sizeof(void *)),
+			std::max(alignment, LINE_SIZE)
+		);
+
+	// Slots larger than a chunk get a chunk of their own
+	chunkSize = roundUp(slotSize, CHUNK_SIZE);
+}
+
+
+Arena::~Arena()
+{
+	for (const auto& chunk : chunks) {
+		munmap(chunk.first, chunkSize);
+	}
+}
+
+
+void * Arena::allocate()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+
+	++used;
+
+	if (free) {
+		void * slot = free;
+		free = *static_cast<void **>(slot);
+		--released;
+		return slot;
+	}
+
+	if (next + slotSize > end) {
+		try {
+			grow();
+		} catch (...) {
+			--used;
+			throw;
+		}
+	}
+
+	void * slot = next;
+	next += slotSize;
+	return slot;
+}
+
+
+void Arena::release(void * slot)
+{
+	if (!slot) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock (mutex);
+
+	*static_cast<void **>(slot) = free;
+	free = slot;
+	--used;
+	++released;
+}
+
+
+void Arena::setPages(Pages pages)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+
+	this->pages = pages;
+}
+
+
+StatsCollector Arena::collectStatistics() const
+{
+	std::lock_guard<std::mutex> lock (mutex);
+
+	unsigned huge = 0;
+
+	for (const auto& chunk : chunks) {
+		huge += chunk.second;
+	}
+
+	StatsCollector stats;
+	stats["arena_chunks"] = chunks.size();
+	stats["arena_huge_chunks"] = huge;
+	stats["arena_reserved_mib"] = chunks.size() * chunkSize >> 20;
+	stats["arena_slot_bytes"] = slotSize;
+	stats["arena_slots"] = used;
+	stats["arena_free_slots"] = released;
+	return stats;
+}
+
+
+void Arena::grow()
+{
+	void * memory = MAP_FAILED;
+	bool huge = false;
+
+#ifdef MAP_HUGETLB
+	if (pages == Pages::EXPLICIT) {
+		// Fails when no huge pages are reserved, falling back on transparent
+		memory = mmap(
+				nullptr, chunkSize, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0
+			);
+		huge = memory != MAP_FAILED;
+	}
+#endif
+
+	if (memory == MAP_FAILED) {
+		// Map an extra chunk, such that an aligned chunk can be cut from it
+		std::size_t mapped = chunkSize + CHUNK_SIZE;
+		char * start = static_cast<char *>(mmap(
+				nullptr, mapped, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+			));
+
+		if (start == MAP_FAILED) {
+			throw std::bad_alloc();
+		}
+
+		char * aligned = reinterpret_cast<char *>(roundUp(
+				reinterpret_cast<std::uintptr_t>(start), CHUNK_SIZE
+			));
+
+		if (aligned != start) {
+			munmap(start, aligned - start);
+		}
+
+		if (aligned + chunkSize != start + mapped) {
+			munmap(aligned + chunkSize, start + mapped - aligned - chunkSize);
+		}
+
+#ifdef MADV_HUGEPAGE
+		// Regular pages are enforced, as the system may default to huge ones
+		madvise(
+				aligned, chunkSize,
+				pages == Pages::NORMAL ? MADV_NOHUGEPAGE : MADV_HUGEPAGE
+			);
+#endif
+
+		memory = aligned;
+	}
+
+	try {
+		chunks.emplace_back(static_cast<char *>(memory), huge);
+	} catch (...) {
+		munmap(memory, chunkSize);
+		throw;
+	}
+
+	next = static_cast<char *>(memory);
+	end = next + chunkSize;
+}
+
+}
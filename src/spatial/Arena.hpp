@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include "StatsCollector.hpp"
+
+namespace Spatial
+{
+
+/**
+ * Pages backing the memory of an arena.
+ */
+enum class Pages
+{
+	/** Regular (4 kB) pages */
+	NORMAL,
+
+	/** Ask the kernel for transparent huge pages (madvise) */
+	TRANSPARENT,
+
+	/** Reserved huge pages (hugetlbfs), or transparent if none are left */
+	EXPLICIT
+};
+
+
+/**
+ * Hands out slots of equal size, e.g. the nodes of a tree.
+ *
+ * Slots are cut from chunks of 2 MB, aligned to 2 MB, such that each chunk
+ * may be backed by a single huge page. Keeping the nodes of a tree
+ * together in a few huge pages saves TLB misses during traversal, and an
+ * allocation is mostly a pointer bump. Released slots are kept in a free
+ * list and handed out again. The chunks are only returned to the system
+ * when the arena is destroyed, which frees all slots at once.
+ *
+ * Allocating and releasing slots is thread safe.
+ */
+class Arena
+{
+	public:
+		/** Size of the chunks, as well as of a huge page */
+		static constexpr std::size_t CHUNK_SIZE = std::size_t(2) << 20;
+
+		/** Size of a cache line, the least alignment of the slots */
+		static constexpr std::size_t LINE_SIZE = 64;
+
+		/**
+		 * Create an empty arena. No memory is reserved until the first
+		 * slot is allocated.
+		 *
+		 * @param size Size of a slot
+		 * @param alignment Alignment of the slots, at most a chunk. They are
+		 *        always aligned to cache lines.
+		 * @param pages Pages backing the chunks
+		 */
+		Arena(
+				std::size_t size,
+				std::size_t alignment = LINE_SIZE,
+				Pages pages = Pages::TRANSPARENT
+			);
+
+		~Arena();
+
+		// Slots would be freed twice
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+
+		/**
+		 * Get an unused slot.
+		 *
+		 * @return Uninitialized memory for an object of the slot size
+		 */
+		void * allocate();
+
+
+		/**
+		 * Return a slot, such that it may be handed out again.
+		 *
+		 * @param slot Slot given by allocate
+		 */
+		void release(void * slot);
+
+
+		/**
+		 * Set the pages backing the chunks reserved from now on.
+		 *
+		 * @param pages Kind of pages
+		 */
+		void setPages(Pages pages);
+
+
+		/**
+		 * Collect the memory usage of this arena.
+		 *
+		 * @return Number of chunks, of which are backed by reserved huge
+		 *         pages, the size of the memory they cover (in MB), the
+		 *         slot size, and the slots in use and in the free list
+		 */
+		StatsCollector collectStatistics() const;
+
+	private:
+		std::size_t slotSize;
+		std::size_t chunkSize;
+		Pages pages;
+
+		// Memory of each chunk, and whether it is backed by huge pages
+		std::vector<std::pair<char *, bool>> chunks;
+
+		// Unused part of the last chunk
+		char * next = nullptr;
+		char * end = nullptr;
+
+		// Released slots, each pointing to the next
+		void * free = nullptr;
+
+		std::size_t used = 0;
+		std::size_t released = 0;
+
+		mutable std::mutex mutex;
+
+
+		/**
+		 * Reserve a new chunk and cut slots from it from now on.
+		 */
+		void grow();
+};
+
+}
@@ -0,0 +1,115 @@
+#include <criterion/criterion.h>
+#include "Arena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace Spatial;
+
+
+/**
+ * Allocate enough slots to span several chunks, and check that they are
+ * aligned and do not overlap.
+ */
+void testSlots(Pages pages)
+{
+	Arena arena (100, 32, pages);
+	std::vector<char *> slots;
+
+	for (unsigned i = 0; i < 50000; ++i) {
+		char * slot = static_cast<char *>(arena.allocate());
+		std::memset(slot, i, 100);
+		slots.push_back(slot);
+	}
+
+	std::sort(slots.begin(), slots.end());
+
+	for (unsigned i = 0; i < slots.size(); ++i) {
+		cr_assert_eq(
+				reinterpret_cast<std::uintptr_t>(slots[i]) % Arena::LINE_SIZE,
+				0u,
+				"Slots should be aligned to cache lines"
+			);
+
+		cr_assert(
+				i == 0 || slots[i - 1] + 100 <= slots[i],
+				"Slots should not overlap"
+			);
+	}
+
+	StatsCollector stats = arena.collectStatistics();
+	cr_assert_eq(stats["arena_slot_bytes"], 128u);
+	cr_assert_eq(stats["arena_slots"], 50000u);
+	cr_assert_eq(stats["arena_chunks"], 4u);
+	cr_assert_eq(stats["arena_reserved_mib"], 8u);
+}
+
+
+Test(Arena, normal)
+{
+	testSlots(Pages::NORMAL);
+}
+
+
+Test(Arena, transparent)
+{
+	testSlots(Pages::TRANSPARENT);
+}
+
+
+Test(Arena, explicit)
+{
+	// Falls back on transparent huge pages when none are reserved
+	testSlots(Pages::EXPLICIT);
+}
+
+
+Test(Arena, reuse)
+{
+	Arena arena (64);
+	std::vector<void *> slots;
+
+	for (unsigned i = 0; i < 10; ++i) {
+		slots.push_back(arena.allocate());
+	}
+
+	arena.release(slots[3]);
+	arena.release(slots[7]);
+
+	StatsCollector stats = arena.collectStatistics();
+	cr_assert_eq(stats["arena_slots"], 8u);
+	cr_assert_eq(stats["arena_free_slots"], 2u);
+
+	cr_assert_eq(arena.allocate(), slots[7], "Released slots should be reused");
+	cr_assert_eq(arena.allocate(), slots[3], "Released slots should be reused");
+	cr_assert_eq(arena.collectStatistics()["arena_free_slots"], 0u);
+}
+
+
+Test(Arena, large)
+{
+	// Slots larger than a chunk
+	Arena arena (3 << 20);
+
+	char * first = static_cast<char *>(arena.allocate());
+	char * second = static_cast<char *>(arena.allocate());
+	std::memset(first, 1, 3 << 20);
+	std::memset(second, 2, 3 << 20);
+
+	cr_assert_eq(first[(3 << 20) - 1], 1);
+	cr_assert_eq(arena.collectStatistics()["arena_chunks"], 2u);
+	cr_assert_eq(arena.collectStatistics()["arena_reserved_mib"], 8u);
+}
+
+
+Test(Arena, alignment)
+{
+	cr_assert_throw(Arena(64, 48), std::invalid_argument);
+
+	Arena arena (100, 256);
+	void * slot = arena.allocate();
+
+	cr_assert_eq(reinterpret_cast<std::uintptr_t>(slot) % 256, 0u);
+	cr_assert_eq(arena.collectStatistics()["arena_slot_bytes"], 256u);
+}
@@ -0,0 +1,27 @@
+#include "ContainsQuery.hpp"
+
+namespace Spatial
+{
+
+ContainsQuery::ContainsQuery(unsigned id, const Box& box)
+	: Query(Query::Type::CONTAINS), box(box), id(id)
+{
+}
+
+std::string ContainsQuery::getName() const
+{
+	return std::to_string(id);
+}
+
+const Box& ContainsQuery::getBox() const
+{
+	return box;
+}
+
+std::ostream& operator<<(std::ostream& stream, const ContainsQuery& query)
+{
+	auto& points = query.getBox().getPoints();
+	return stream << "contains " << points.first << ' ' << points.second;
+}
+
+}
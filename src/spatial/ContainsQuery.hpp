@@ -0,0 +1,27 @@
+#pragma once
+#include "Box.hpp"
+#include "Query.hpp"
+
+namespace Spatial
+{
+
+/**
+ * Query for the objects containing a box.
+ */
+class ContainsQuery : public Query
+{
+	public:
+		ContainsQuery(unsigned id, const Box& box);
+
+		std::string getName() const;
+		const Box& getBox() const;
+
+	private:
+		Box box;
+		unsigned id;
+
+};
+
+std::ostream& operator<<(std::ostream& stream, const ContainsQuery& query);
+
+}
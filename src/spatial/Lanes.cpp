@@ -0,0 +1,43 @@
+#include "Lanes.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace Spatial
+{
+
+Simd detectSimd()
+{
+	__builtin_cpu_init();
+
+	Simd supported = Simd::SSE2;
+
+	if (__builtin_cpu_supports("avx512f")) {
+		supported = Simd::AVX512;
+	} else if (__builtin_cpu_supports("avx2")) {
+		supported = Simd::AVX2;
+	}
+
+	const char * forced = std::getenv("SIMD");
+
+	if (!forced) {
+		return supported;
+	}
+
+	const std::string name (forced);
+	Simd wanted = supported;
+
+	if (name == "sse2") {
+		wanted = Simd::SSE2;
+	} else if (name == "avx2") {
+		wanted = Simd::AVX2;
+	}
+
+	// Never pick an instruction set the CPU lacks
+	return std::min(wanted, supported);
+}
+
+
+const Simd simd = detectSimd();
+
+}
@@ -0,0 +1,658 @@
+#pragma once
+#include "immintrin.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace Spatial
+{
+
+/**
+ * Vector instruction sets the kernels are compiled for, least capable first.
+ */
+enum class Simd
+{
+	SSE2,
+	AVX2,
+	AVX512
+};
+
+
+/**
+ * Find the most capable instruction set supported by this CPU (and OS).
+ *
+ * A less capable one may be forced through the SIMD environment variable
+ * ("sse2", "avx2" or "avx512"), e.g. to compare them on the same machine.
+ */
+Simd detectSimd();
+
+
+/**
+ * Instruction set used by `DispatchedLanes`, detected once when loaded.
+ */
+extern const Simd simd;
+
+
+/**
+ * Vector kernels on blocks of W doubles with SSE2, two at a time.
+ *
+ * The kernels work on the layout shared by the vectorized indexes, where the
+ * bottoms of a block are followed by its tops for each dimension in turn.
+ * All loads are aligned, and comparisons give a bitset with a bit for each
+ * double in the block. Only the _CMP_LE_OS, _CMP_GE_OS, _CMP_LT_OS and
+ * _CMP_GT_OS comparisons are supported.
+ *
+ * Every x86-64 CPU supports SSE2, so these kernels need no special flags.
+ *
+ * @tparam W Doubles in a block (multiple of two)
+ */
+template<unsigned W>
+struct BasicSse2Lanes
+{
+	static constexpr unsigned WIDTH = W;
+
+
+	/**
+	 * Compare the bottoms and tops in a block against a reference value each
+	 * for every dimension.
+	 *
+	 * @tparam BOTTOM_OP Compare operation for the bottoms (e.g. _CMP_LE_OS)
+	 * @tparam TOP_OP Compare operation for the tops
+	 *
+	 * @param base Bottoms of the first dimension
+	 * @param stride Distance from the bottoms to the tops of a dimension, and
+	 *     from the tops to the bottoms of the next one
+	 * @param dimension Number of dimensions
+	 * @param bottoms Reference values for the bottoms
+	 * @param tops Reference values for the tops
+	 * @return Bitset of entries passing all comparisons
+	 */
+	template<int BOTTOM_OP, int TOP_OP>
+	static unsigned block(
+			const double * base,
+			std::size_t stride,
+			unsigned dimension,
+			const double * bottoms,
+			const double * tops
+		)
+	{
+		unsigned bitset = (1u << W) - 1;
+
+		for (unsigned j = 0; j < dimension; ++j) {
+			const __m128d bottom = _mm_set1_pd(bottoms[j]);
+			const __m128d top = _mm_set1_pd(tops[j]);
+			unsigned passed = 0;
+
+			for (unsigned i = 0; i < W; i += 2) {
+				passed |= (
+						compare<BOTTOM_OP>(_mm_load_pd(base + i), bottom)
+						& compare<TOP_OP>(_mm_load_pd(base + stride + i), top)
+					) << i;
+			}
+
+			bitset &= passed;
+			base += 2 * stride;
+		}
+
+		return bitset;
+	}
+
+
+	/**
+	 * Compare consecutive values against a reference value.
+	 *
+	 * @tparam OP Compare operation (e.g. _CMP_LE_OS)
+	 *
+	 * @param subjects Values to compare
+	 * @param reference Reference value
+	 * @param n Number of values (multiple of W, at most 32)
+	 * @return Bitset of values passing the comparison
+	 */
+	template<int OP>
+	static std::uint32_t strip(
+			const double * subjects,
+			const double * reference,
+			unsigned n
+		)
+	{
+		const __m128d value = _mm_set1_pd(*reference);
+		std::uint32_t bitset = 0;
+
+		for (unsigned i = 0; i < n; i += 2) {
+			bitset |= compare<OP>(_mm_load_pd(subjects + i), value) << i;
+		}
+
+		return bitset;
+	}
+
+
+	/**
+	 * Calculate the squared distance from an MBR to the entries in a block.
+	 *
+	 * @param base Bottoms of the first dimension
+	 * @param stride @see block
+	 * @param dimension Number of dimensions
+	 * @param lows Bottom of the MBR
+	 * @param highs Top of the MBR
+	 * @param distances Output, W distances
+	 */
+	static void distance(
+			const double * base,
+			std::size_t stride,
+			unsigned dimension,
+			const double * lows,
+			const double * highs,
+			double * distances
+		)
+	{
+		const __m128d zero = _mm_setzero_pd();
+
+		for (unsigned i = 0; i < W; i += 2) {
+			__m128d sum = zero;
+
+			for (unsigned j = 0; j < dimension; ++j) {
+				const double * bottoms = base + 2 * stride * j + i;
+
+				// Gap below or above the MBR, whichever is positive
+				__m128d gap = _mm_max_pd(
+						_mm_max_pd(
+							zero,
+							_mm_sub_pd(
+								_mm_load_pd(bottoms),
+								_mm_set1_pd(highs[j])
+							)
+						),
+						_mm_sub_pd(
+							_mm_set1_pd(lows[j]),
+							_mm_load_pd(bottoms + stride)
+						)
+					);
+
+				sum = _mm_add_pd(sum, _mm_mul_pd(gap, gap));
+			}
+
+			_mm_storeu_pd(distances + i, sum);
+		}
+	}
+
+
+	/**
+	 * Write the positions of all set bits in a bitset, lowest first.
+	 *
+	 * @param bits Bitset
+	 * @param positions Output, with room for 16 positions past the last
+	 * @return Number of positions written
+	 */
+	static unsigned compress(std::uint32_t bits, std::uint8_t * positions)
+	{
+		unsigned n = 0;
+
+		for (; bits; bits &= bits - 1) {
+			positions[n++] = __builtin_ctz(bits);
+		}
+
+		return n;
+	}
+
+
+	private:
+		template<int OP>
+		static unsigned compare(__m128d a, __m128d b)
+		{
+			switch (OP) {
+				case _CMP_LE_OS:
+					return _mm_movemask_pd(_mm_cmple_pd(a, b));
+
+				case _CMP_GE_OS:
+					return _mm_movemask_pd(_mm_cmpge_pd(a, b));
+
+				case _CMP_LT_OS:
+					return _mm_movemask_pd(_mm_cmplt_pd(a, b));
+
+				default:
+					return _mm_movemask_pd(_mm_cmpgt_pd(a, b));
+			}
+		}
+};
+
+
+// The kernels below are compiled for their instruction set whatever the
+// build targets, and must only be called when the CPU supports it
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+/**
+ * Vector kernels on blocks of W doubles with AVX2, four at a time.
+ *
+ * @see BasicSse2Lanes
+ * @tparam W Doubles in a block (multiple of four)
+ */
+template<unsigned W>
+struct BasicAvx2Lanes
+{
+	static constexpr unsigned WIDTH = W;
+
+
+	/**
+	 * @see BasicSse2Lanes::block
+	 */
+	template<int BOTTOM_OP, int TOP_OP>
+	static unsigned block(
+			const double * base,
+			std::size_t stride,
+			unsigned dimension,
+			const double * bottoms,
+			const double * tops
+		)
+	{
+		unsigned bitset = (1u << W) - 1;
+
+		for (unsigned j = 0; j < dimension; ++j) {
+			const __m256d bottom = _mm256_broadcast_sd(&bottoms[j]);
+			const __m256d top = _mm256_broadcast_sd(&tops[j]);
+			unsigned passed = 0;
+
+			for (unsigned i = 0; i < W; i += 4) {
+				passed |= (
+						compare<BOTTOM_OP>(_mm256_load_pd(base + i), bottom)
+						& compare<TOP_OP>(_mm256_load_pd(base + stride + i), top)
+					) << i;
+			}
+
+			bitset &= passed;
+			base += 2 * stride;
+		}
+
+		return bitset;
+	}
+
+
+	/**
+	 * @see BasicSse2Lanes::strip
+	 */
+	template<int OP>
+	static std::uint32_t strip(
+			const double * subjects,
+			const double * reference,
+			unsigned n
+		)
+	{
+		const __m256d value = _mm256_broadcast_sd(reference);
+		std::uint32_t bitset = 0;
+
+		for (unsigned i = 0; i < n; i += 4) {
+			bitset |= compare<OP>(_mm256_load_pd(subjects + i), value) << i;
+		}
+
+		return bitset;
+	}
+
+
+	/**
+	 * @see BasicSse2Lanes::distance
+	 */
+	static void distance(
+			const double * base,
+			std::size_t stride,
+			unsigned dimension,
+			const double * lows,
+			const double * highs,
+			double * distances
+		)
+	{
+		const __m256d zero = _mm256_setzero_pd();
+
+		for (unsigned i = 0; i < W; i += 4) {
+			__m256d sum = zero;
+
+			for (unsigned j = 0; j < dimension; ++j) {
+				const double * bottoms = base + 2 * stride * j + i;
+
+				__m256d gap = _mm256_max_pd(
+						_mm256_max_pd(
+							zero,
+							_mm256_sub_pd(
+								_mm256_load_pd(bottoms),
+								_mm256_broadcast_sd(&highs[j])
+							)
+						),
+						_mm256_sub_pd(
+							_mm256_broadcast_sd(&lows[j]),
+							_mm256_load_pd(bottoms + stride)
+						)
+					);
+
+				sum = _mm256_add_pd(sum, _mm256_mul_pd(gap, gap));
+			}
+
+			_mm256_storeu_pd(distances + i, sum);
+		}
+	}
+
+
+	/**
+	 * @see BasicSse2Lanes::compress
+	 */
+	static unsigned compress(std::uint32_t bits, std::uint8_t * positions)
+	{
+		return BasicSse2Lanes<W>::compress(bits, positions);
+	}
+
+
+	private:
+		template<int OP>
+		static unsigned compare(__m256d a, __m256d b)
+		{
+			return _mm256_movemask_pd(_mm256_cmp_pd(a, b, OP));
+		}
+};
+
+#pragma GCC pop_options
+
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+/**
+ * Vector kernels on blocks of W doubles with AVX-512, eight at a time.
+ *
+ * Comparisons give the mask register as is, and the positions of set bits
+ * are written with a compressing store rather than bit by bit.
+ *
+ * @see BasicSse2Lanes
+ * @tparam W Doubles in a block (multiple of eight)
+ */
+template<unsigned W>
+struct BasicAvx512Lanes
+{
+	static constexpr unsigned WIDTH = W;
+
+
+	/**
+	 * @see BasicSse2Lanes::block
+	 */
+	template<int BOTTOM_OP, int TOP_OP>
+	static unsigned block(
+			const double * base,
+			std::size_t stride,
+			unsigned dimension,
+			const double * bottoms,
+			const double * tops
+		)
+	{
+		unsigned bitset = (1u << W) - 1;
+
+		for (unsigned j = 0; j < dimension; ++j) {
+			const __m512d bottom = _mm512_set1_pd(bottoms[j]);
+			const __m512d top = _mm512_set1_pd(tops[j]);
+			unsigned passed = 0;
+
+			for (unsigned i = 0; i < W; i += 8) {
+				passed |= unsigned(
+						_mm512_cmp_pd_mask(
+							_mm512_load_pd(base + i), bottom, BOTTOM_OP
+						) & _mm512_cmp_pd_mask(
+							_mm512_load_pd(base + stride + i), top, TOP_OP
+						)
+					) << i;
+			}
+
+			bitset &= passed;
+			base += 2 * stride;
+		}
+
+		return bitset;
+	}
+
+
+	/**
+	 * @see BasicSse2Lanes::strip
+	 */
+	template<int OP>
+	static std::uint32_t strip(
+			const double * subjects,
+			const double * reference,
+			unsigned n
+		)
+	{
+		const __m512d value = _mm512_set1_pd(*reference);
+		std::uint32_t bitset = 0;
+
+		for (unsigned i = 0; i < n; i += 8) {
+			bitset |= std::uint32_t(_mm512_cmp_pd_mask(
+					_mm512_load_pd(subjects + i), value, OP
+				)) << i;
+		}
+
+		return bitset;
+	}
+
+
+	/**
+	 * @see BasicSse2Lanes::distance
+	 */
+	static void distance(
+			const double * base,
+			std::size_t stride,
+			unsigned dimension,
+			const double * lows,
+			const double * highs,
+			double * distances
+		)
+	{
+		const __m512d zero = _mm512_setzero_pd();
+
+		for (unsigned i = 0; i < W; i += 8) {
+			__m512d sum = zero;
+
+			for (unsigned j = 0; j < dimension; ++j) {
+				const double * bottoms = base + 2 * stride * j + i;
+
+				// The masked maximum avoids a spurious warning on the
+				// undefined merge source of _mm512_max_pd
+				__m512d gap = _mm512_maskz_max_pd(
+						0xFF,
+						_mm512_maskz_max_pd(
+							0xFF,
+							zero,
+							_mm512_sub_pd(
+								_mm512_load_pd(bottoms),
+								_mm512_set1_pd(highs[j])
+							)
+						),
+						_mm512_sub_pd(
+							_mm512_set1_pd(lows[j]),
+							_mm512_load_pd(bottoms + stride)
+						)
+					);
+
+				sum = _mm512_add_pd(sum, _mm512_mul_pd(gap, gap));
+			}
+
+			_mm512_storeu_pd(distances + i, sum);
+		}
+	}
+
+
+	/**
+	 * Write the positions of all set bits in a bitset, lowest first.
+	 *
+	 * Sixteen bits are handled at a time by compressing the positions of the
+	 * set bits into the low lanes of a vector, which is narrowed to bytes
+	 * and stored whole.
+	 *
+	 * @see BasicSse2Lanes::compress
+	 */
+	static unsigned compress(std::uint32_t bits, std::uint8_t * positions)
+	{
+		const __m512i sequence = _mm512_set_epi32(
+				15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+			);
+
+		unsigned n = 0;
+
+		for (unsigned offset = 0; bits; offset += 16, bits >>= 16) {
+			const __mmask16 mask = bits;
+
+			if (!mask) {
+				continue;
+			}
+
+			const __m512i compressed = _mm512_maskz_compress_epi32(
+					mask,
+					_mm512_add_epi32(sequence, _mm512_set1_epi32(offset))
+				);
+
+			_mm_storeu_si128(
+					reinterpret_cast<__m128i *>(positions + n),
+					_mm512_cvtepi32_epi8(compressed)
+				);
+
+			n += __builtin_popcount(mask);
+		}
+
+		return n;
+	}
+};
+
+#pragma GCC pop_options
+
+
+/**
+ * AVX2 kernels on four doubles at a time, for builds targeting AVX2.
+ */
+using Avx2Lanes = BasicAvx2Lanes<4>;
+
+
+/**
+ * AVX-512 kernels on eight doubles at a time, for builds targeting AVX-512.
+ */
+using Avx512Lanes = BasicAvx512Lanes<8>;
+
+
+/**
+ * Kernels on blocks of eight doubles with the instruction set picked at
+ * runtime.
+ *
+ * The blocks are as wide as the widest vectors, such that the same layout
+ * is scanned a vector at a time with AVX-512, or two and four at a time
+ * with AVX2 and SSE2. Each kernel is a call through a predictable branch on
+ * `simd` rather than inlined, which pays off for builds that must run on
+ * any x86-64 CPU.
+ */
+struct DispatchedLanes
+{
+	static constexpr unsigned WIDTH = 8;
+
+
+	/**
+	 * @see BasicSse2Lanes::block
+	 */
+	template<int BOTTOM_OP, int TOP_OP>
+	static unsigned block(
+			const double * base,
+			std::size_t stride,
+			unsigned dimension,
+			const double * bottoms,
+			const double * tops
+		)
+	{
+		switch (simd) {
+			case Simd::AVX512:
+				return BasicAvx512Lanes<WIDTH>::block<BOTTOM_OP, TOP_OP>(
+						base, stride, dimension, bottoms, tops
+					);
+
+			case Simd::AVX2:
+				return BasicAvx2Lanes<WIDTH>::block<BOTTOM_OP, TOP_OP>(
+						base, stride, dimension, bottoms, tops
+					);
+
+			default:
+				return BasicSse2Lanes<WIDTH>::block<BOTTOM_OP, TOP_OP>(
+						base, stride, dimension, bottoms, tops
+					);
+		}
+	}
+
+
+	/**
+	 * @see BasicSse2Lanes::strip
+	 */
+	template<int OP>
+	static std::uint32_t strip(
+			const double * subjects,
+			const double * reference,
+			unsigned n
+		)
+	{
+		switch (simd) {
+			case Simd::AVX512:
+				return BasicAvx512Lanes<WIDTH>::strip<OP>(
+						subjects, reference, n
+					);
+
+			case Simd::AVX2:
+				return BasicAvx2Lanes<WIDTH>::strip<OP>(subjects, reference, n);
+
+			default:
+				return BasicSse2Lanes<WIDTH>::strip<OP>(subjects, reference, n);
+		}
+	}
+
+
+	/**
+	 * @see BasicSse2Lanes::distance
+	 */
+	static void distance(
+			const double * base,
+			std::size_t stride,
+			unsigned dimension,
+			const double * lows,
+			const double * highs,
+			double * distances
+		)
+	{
+		switch (simd) {
+			case Simd::AVX512:
+				return BasicAvx512Lanes<WIDTH>::distance(
+						base, stride, dimension, lows, highs, distances
+					);
+
+			case Simd::AVX2:
+				return BasicAvx2Lanes<WIDTH>::distance(
+						base, stride, dimension, lows, highs, distances
+					);
+
+			default:
+				return BasicSse2Lanes<WIDTH>::distance(
+						base, stride, dimension, lows, highs, distances
+					);
+		}
+	}
+
+
+	/**
+	 * @see BasicSse2Lanes::compress
+	 */
+	static unsigned compress(std::uint32_t bits, std::uint8_t * positions)
+	{
+		if (simd == Simd::AVX512) {
+			return BasicAvx512Lanes<WIDTH>::compress(bits, positions);
+		}
+
+		return BasicSse2Lanes<WIDTH>::compress(bits, positions);
+	}
+};
+
+
+/**
+ * Kernels for the build target: inlined when it supports AVX2 (as with
+ * -march=native on most machines), and picked at runtime otherwise.
+ */
+#ifdef __AVX2__
+using DefaultLanes = Avx2Lanes;
+#else
+using DefaultLanes = DispatchedLanes;
+#endif
+
+}
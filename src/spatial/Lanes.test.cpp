@@ -0,0 +1,142 @@
+#include <criterion/criterion.h>
+#include "Lanes.hpp"
+#include <random>
+
+using namespace Spatial;
+
+
+// Blocks of the widest kernels, for two dimensions
+constexpr unsigned W = 8;
+constexpr unsigned D = 2;
+
+
+/**
+ * Compare the kernels against scalar code on random blocks, with values from
+ * a small range such that many are equal.
+ */
+template<class L>
+void testKernels()
+{
+	std::mt19937 generator (42);
+	std::uniform_int_distribution<int> value (0, 8);
+
+	alignas(64) double block[2 * D * W];
+	double bottoms[D], tops[D];
+
+	for (unsigned round = 0; round < 1000; ++round) {
+		for (double& v : block) {
+			v = value(generator);
+		}
+
+		for (unsigned j = 0; j < D; ++j) {
+			bottoms[j] = value(generator);
+			tops[j] = value(generator);
+		}
+
+		unsigned intersecting = 0, within = 0;
+		double distances[W];
+
+		for (unsigned i = 0; i < W; ++i) {
+			bool intersects = true, inside = true;
+			double distance = 0.0;
+
+			for (unsigned j = 0; j < D; ++j) {
+				double bottom = block[2 * W * j + i];
+				double top = block[2 * W * j + W + i];
+				double gap = std::max(
+						std::max(0.0, bottom - tops[j]),
+						bottoms[j] - top
+					);
+
+				intersects = intersects && bottom <= tops[j] && top >= bottoms[j];
+				inside = inside && bottom >= bottoms[j] && top <= tops[j];
+				distance += gap * gap;
+			}
+
+			intersecting |= intersects << i;
+			within |= inside << i;
+			distances[i] = distance;
+		}
+
+		cr_assert_eq(
+				(L::template block<_CMP_LE_OS, _CMP_GE_OS>(
+					block, W, D, tops, bottoms
+				)),
+				intersecting,
+				"Block should give the intersecting entries"
+			);
+
+		cr_assert_eq(
+				(L::template block<_CMP_GE_OS, _CMP_LE_OS>(
+					block, W, D, bottoms, tops
+				)),
+				within,
+				"Block should give the entries within"
+			);
+
+		std::uint32_t below = 0;
+
+		for (unsigned i = 0; i < 2 * D * W; ++i) {
+			below |= std::uint32_t(block[i] < bottoms[0]) << i;
+		}
+
+		cr_assert_eq(
+				L::template strip<_CMP_LT_OS>(block, bottoms, 2 * D * W),
+				below,
+				"Strip should give the values passing the comparison"
+			);
+
+		double found[W];
+		L::distance(block, W, D, bottoms, tops, found);
+
+		for (unsigned i = 0; i < W; ++i) {
+			cr_assert_eq(found[i], distances[i], "Distances should match");
+		}
+
+		std::uint8_t positions[32 + 16];
+		unsigned n = L::compress(below, positions);
+
+		cr_assert_eq(
+				n,
+				unsigned(__builtin_popcount(below)),
+				"Every set bit should be found"
+			);
+
+		for (unsigned i = 0; i < n; ++i) {
+			cr_assert(below >> positions[i] & 1, "Positions should be set");
+			cr_assert(i == 0 || positions[i - 1] < positions[i], "Lowest first");
+		}
+	}
+}
+
+
+Test(Lanes, sse2)
+{
+	testKernels<BasicSse2Lanes<W>>();
+}
+
+
+Test(Lanes, avx2)
+{
+	if (simd < Simd::AVX2) {
+		cr_skip_test("AVX2 not supported");
+	}
+
+	testKernels<BasicAvx2Lanes<W>>();
+}
+
+
+Test(Lanes, avx512)
+{
+	if (simd < Simd::AVX512) {
+		cr_skip_test("AVX-512 not supported");
+	}
+
+	testKernels<BasicAvx512Lanes<W>>();
+}
+
+
+Test(Lanes, dispatched)
+{
+	testKernels<DispatchedLanes>();
+}
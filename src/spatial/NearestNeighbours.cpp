@@ -0,0 +1,31 @@
+#include "NearestNeighbours.hpp"
+
+namespace Spatial
+{
+
+NearestNeighbours::NearestNeighbours(unsigned k)
+	: k(k)
+{
+	heap.reserve(k);
+}
+
+
+void NearestNeighbours::merge(const NearestNeighbours& other)
+{
+	for (const Candidate& candidate : other.heap) {
+		offer(candidate.first, candidate.second);
+	}
+}
+
+
+void NearestNeighbours::extract(Results& results) const
+{
+	std::vector<Candidate> sorted (heap);
+	std::sort_heap(sorted.begin(), sorted.end());
+
+	for (const Candidate& candidate : sorted) {
+		results.push_back(candidate.second);
+	}
+}
+
+}
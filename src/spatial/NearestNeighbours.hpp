@@ -0,0 +1,80 @@
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "DataObject.hpp"
+#include "Results.hpp"
+
+namespace Spatial
+{
+
+/**
+ * Keeps the k nearest objects seen so far, for brute force k-NN search.
+ *
+ * The candidates are kept in a max-heap bounded to k entries. Ties in
+ * distance are broken by id, so the outcome does not depend on the order the
+ * objects are offered in. Each thread may thus fill its own set, and the sets
+ * are merged afterwards.
+ */
+class NearestNeighbours
+{
+	public:
+		using Id = DataObject::Id;
+
+		NearestNeighbours(unsigned k);
+
+
+		/**
+		 * Distance of the farthest candidate, when there are k of them.
+		 *
+		 * Objects farther away than this are never accepted.
+		 */
+		double bound() const
+		{
+			return heap.size() < k
+				? std::numeric_limits<double>::infinity()
+				: heap.front().first;
+		}
+
+
+		/**
+		 * Offer an object as candidate.
+		 *
+		 * @param distance Distance (or squared distance) to the query
+		 * @param id Id of the object
+		 */
+		void offer(double distance, Id id)
+		{
+			const Candidate candidate (distance, id);
+
+			if (heap.size() < k) {
+				heap.push_back(candidate);
+				std::push_heap(heap.begin(), heap.end());
+			} else if (k && candidate < heap.front()) {
+				std::pop_heap(heap.begin(), heap.end());
+				heap.back() = candidate;
+				std::push_heap(heap.begin(), heap.end());
+			}
+		}
+
+
+		/**
+		 * Offer all candidates of another set.
+		 */
+		void merge(const NearestNeighbours& other);
+
+
+		/**
+		 * Append the candidates to a result set, nearest first.
+		 */
+		void extract(Results& results) const;
+
+	private:
+		using Candidate = std::pair<double, Id>;
+
+		unsigned k;
+		std::vector<Candidate> heap;
+};
+
+}
@@ -0,0 +1,39 @@
+#include <criterion/criterion.h>
+#include "NearestNeighbours.hpp"
+
+using namespace Spatial;
+
+
+Test(NearestNeighbours, nearest_first)
+{
+	NearestNeighbours nearest (3);
+
+	for (DataObject::Id id = 1; id <= 10; ++id) {
+		nearest.offer((id * 7) % 11, id);
+	}
+
+	Results results;
+	nearest.extract(results);
+
+	// Distances 7, 3, 10, 6, 2, 9, 5, 1, 8, 4 for ids 1 to 10
+	cr_expect_eq(results, Results({8, 5, 2}), "Should keep the 3 nearest");
+	cr_expect_eq(nearest.bound(), 3.0, "Bound should be the farthest kept");
+}
+
+
+Test(NearestNeighbours, merge_ties)
+{
+	NearestNeighbours a (2), b (2);
+
+	a.offer(1.0, 4);
+	a.offer(1.0, 3);
+	b.offer(1.0, 2);
+	b.offer(1.0, 5);
+
+	a.merge(b);
+
+	Results results;
+	a.extract(results);
+
+	cr_expect_eq(results, Results({2, 3}), "Ties should be broken by id");
+}
@@ -0,0 +1,85 @@
+#include "PairSink.hpp"
+
+namespace Spatial
+{
+
+constexpr std::size_t PairSink::CHUNK_SIZE;
+
+
+PairSink::PairSink(Pair * buffer, std::size_t capacity)
+	: buffer(buffer), capacity(capacity)
+{
+}
+
+
+PairSink::~PairSink()
+{
+}
+
+
+void PairSink::finish()
+{
+	// A stopped sink has already flushed its (full) buffer
+	if (stopped || !size) {
+		return;
+	}
+
+	flush(buffer, buffer + size);
+	size = 0;
+}
+
+
+bool PairSink::isStopped() const
+{
+	return stopped;
+}
+
+
+bool PairSink::drain()
+{
+	if (stopped) {
+		return false;
+	}
+
+	if (!flush(buffer, buffer + size)) {
+		stopped = true;
+		return false;
+	}
+
+	size = 0;
+	return true;
+}
+
+
+VectorPairSink::VectorPairSink(std::vector<Pair>& pairs)
+	: PairSink(chunk, CHUNK_SIZE), pairs(pairs)
+{
+}
+
+
+bool VectorPairSink::flush(const Pair * first, const Pair * last)
+{
+	pairs.insert(pairs.end(), first, last);
+	return true;
+}
+
+
+CountingPairSink::CountingPairSink()
+	: PairSink(chunk, CHUNK_SIZE)
+{
+}
+
+
+unsigned long long CountingPairSink::getCount() const
+{
+	return count;
+}
+
+
+bool CountingPairSink::flush(const Pair * first, const Pair * last)
+{
+	count += last - first;
+	return true;
+}
+
+}
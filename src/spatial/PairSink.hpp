@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "DataObject.hpp"
+
+namespace Spatial
+{
+
+/**
+ * Receives the results of a join, as pairs of object ids.
+ *
+ * Works like `ResultSink`: Indexes push pairs into a buffer, which is handed
+ * to flush whenever it is full and once the join is done. The first id of a
+ * pair belongs to the index running the join, the second to the other index.
+ *
+ * A sink is not thread safe. Once flush has asked to stop, the sink stays
+ * stopped and further pairs are discarded.
+ */
+class PairSink
+{
+	public:
+		using Id = DataObject::Id;
+		using Pair = std::pair<Id, Id>;
+
+		/** Size of the buffer used by the sinks owning one */
+		static constexpr std::size_t CHUNK_SIZE = 256;
+
+		PairSink(Pair * buffer, std::size_t capacity);
+		virtual ~PairSink();
+
+		// Buffer would be shared
+		PairSink(const PairSink&) = delete;
+		PairSink& operator=(const PairSink&) = delete;
+
+
+		/**
+		 * Add a pair.
+		 *
+		 * @param left Id of the object in the joining index
+		 * @param right Id of the object in the other index
+		 * @return False if the join should stop
+		 */
+		bool push(Id left, Id right)
+		{
+			if (size == capacity && !drain()) {
+				return false;
+			}
+
+			buffer[size].first = left;
+			buffer[size].second = right;
+			++size;
+			return true;
+		}
+
+
+		/**
+		 * Add a range of pairs, e.g. collected by a single thread.
+		 *
+		 * @param first First pair
+		 * @param last One past the last pair
+		 * @return False if the join should stop
+		 */
+		bool append(const Pair * first, const Pair * last)
+		{
+			for (; first != last; ++first) {
+				if (!push(first->first, first->second)) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+
+		/**
+		 * Flush the remaining pairs. Called once the join is done.
+		 */
+		void finish();
+
+
+		/**
+		 * @return True if the sink asked the join to stop
+		 */
+		bool isStopped() const;
+
+	protected:
+
+		/**
+		 * Receive a chunk of pairs.
+		 *
+		 * @param first First pair in the chunk
+		 * @param last One past the last pair in the chunk
+		 * @return False if the join should stop
+		 */
+		virtual bool flush(const Pair * first, const Pair * last) = 0;
+
+	private:
+		Pair * buffer;
+		std::size_t capacity;
+		std::size_t size = 0;
+		bool stopped = false;
+
+		bool drain();
+};
+
+
+/**
+ * Appends the pairs to a vector.
+ */
+class VectorPairSink : public PairSink
+{
+	public:
+		VectorPairSink(std::vector<Pair>& pairs);
+
+	protected:
+		bool flush(const Pair * first, const Pair * last) override;
+
+	private:
+		std::vector<Pair>& pairs;
+		Pair chunk[CHUNK_SIZE];
+};
+
+
+/**
+ * Counts the pairs without storing them.
+ */
+class CountingPairSink : public PairSink
+{
+	public:
+		CountingPairSink();
+
+		unsigned long long getCount() const;
+
+	protected:
+		bool flush(const Pair * first, const Pair * last) override;
+
+	private:
+		unsigned long long count = 0;
+		Pair chunk[CHUNK_SIZE];
+};
+
+}
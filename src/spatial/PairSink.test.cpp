@@ -0,0 +1,38 @@
+#include <criterion/criterion.h>
+#include "PairSink.hpp"
+#include <vector>
+
+using namespace Spatial;
+
+
+Test(PairSink, vector)
+{
+	std::vector<PairSink::Pair> pairs;
+	VectorPairSink sink (pairs);
+
+	// Enough pairs to flush a few chunks
+	for (DataObject::Id id = 0; id < 1000; ++id) {
+		cr_expect(sink.push(id, 2 * id), "Vector sink should never stop");
+	}
+
+	sink.finish();
+
+	cr_expect_eq(pairs.size(), 1000u, "All pairs should be appended");
+	cr_expect_eq(pairs[0].second, 0u, "Pairs should keep their order");
+	cr_expect_eq(pairs[999].first, 999u, "Pairs should keep their order");
+	cr_expect_eq(pairs[999].second, 1998u, "Pairs should keep both ids");
+}
+
+
+Test(PairSink, counting)
+{
+	CountingPairSink sink;
+
+	for (DataObject::Id id = 0; id < 1000; ++id) {
+		sink.push(id, id);
+	}
+
+	sink.finish();
+
+	cr_expect_eq(sink.getCount(), 1000u, "All pairs should be counted");
+}
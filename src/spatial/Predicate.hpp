@@ -0,0 +1,16 @@
+#pragma once
+
+namespace Spatial
+{
+
+/**
+ * Relation between the box of an object and a query box.
+ */
+enum class Predicate
+{
+	INTERSECTS, // The object intersects the query
+	CONTAINS,   // The object contains the query
+	WITHIN      // The object lies within the query
+};
+
+}
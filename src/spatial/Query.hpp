@@ -8,12 +8,15 @@ namespace Spatial
 /**
  * Represents a query.
  *
- * The query may be either a range query or a k-nn query.
+ * The query may be a range query (objects intersecting a box), a k-nn query,
+ * a containment query (objects containing or within a box), a stabbing
+ * query (objects containing a point) or a radius query (objects within a
+ * distance of a box).
  */
 class Query
 {
 	public:
-		enum Type{RANGE, KNN};
+		enum Type{RANGE, KNN, CONTAINS, WITHIN, STAB, RADIUS};
 
 		Query() = default;
 		virtual ~Query() = default;
@@ -0,0 +1,42 @@
+#include "RadiusQuery.hpp"
+#include <stdexcept>
+
+namespace Spatial
+{
+
+RadiusQuery::RadiusQuery(unsigned id, const Box& box, double radius)
+	: Query(Query::Type::RADIUS), box(box), radius(radius), id(id)
+{
+	if (radius < 0.0) {
+		throw std::invalid_argument("Radius must not be negative");
+	}
+}
+
+RadiusQuery::RadiusQuery(unsigned id, const Point& point, double radius)
+	: RadiusQuery(id, Box(point, point), radius)
+{
+}
+
+std::string RadiusQuery::getName() const
+{
+	return std::to_string(id);
+}
+
+const Box& RadiusQuery::getBox() const
+{
+	return box;
+}
+
+double RadiusQuery::getRadius() const
+{
+	return radius;
+}
+
+std::ostream& operator<<(std::ostream& stream, const RadiusQuery& query)
+{
+	auto& points = query.getBox().getPoints();
+	return stream << "radius " << query.getRadius() << ' '
+		<< points.first << ' ' << points.second;
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "Box.hpp"
+#include "Query.hpp"
+
+namespace Spatial
+{
+
+/**
+ * Query for the objects within a distance of a box (or point).
+ *
+ * The distance between two boxes is the (Euclidean) distance between their
+ * closest points, thus 0 if they intersect.
+ */
+class RadiusQuery : public Query
+{
+	public:
+		RadiusQuery(unsigned id, const Box& box, double radius);
+		RadiusQuery(unsigned id, const Point& point, double radius);
+
+		std::string getName() const;
+		const Box& getBox() const;
+		double getRadius() const;
+
+	private:
+		Box box;
+		double radius;
+		unsigned id;
+
+};
+
+std::ostream& operator<<(std::ostream& stream, const RadiusQuery& query);
+
+}
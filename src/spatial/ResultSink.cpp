@@ -0,0 +1,106 @@
+#include "ResultSink.hpp"
+
+namespace Spatial
+{
+
+constexpr std::size_t ResultSink::CHUNK_SIZE;
+
+
+ResultSink::ResultSink(Id * buffer, std::size_t capacity)
+	: buffer(buffer), capacity(capacity)
+{
+}
+
+
+ResultSink::~ResultSink()
+{
+}
+
+
+void ResultSink::finish()
+{
+	// A stopped sink has already flushed its (full) buffer
+	if (stopped || !size) {
+		return;
+	}
+
+	flush(buffer, buffer + size);
+	size = 0;
+}
+
+
+bool ResultSink::isStopped() const
+{
+	return stopped;
+}
+
+
+bool ResultSink::drain()
+{
+	if (stopped) {
+		return false;
+	}
+
+	if (!flush(buffer, buffer + size)) {
+		stopped = true;
+		return false;
+	}
+
+	size = 0;
+	return true;
+}
+
+
+VectorSink::VectorSink(Results& results)
+	: ResultSink(chunk, CHUNK_SIZE), results(results)
+{
+}
+
+
+bool VectorSink::flush(const Id * first, const Id * last)
+{
+	results.insert(results.end(), first, last);
+	return true;
+}
+
+
+CountingSink::CountingSink()
+	: ResultSink(chunk, CHUNK_SIZE)
+{
+}
+
+
+unsigned long long CountingSink::getCount() const
+{
+	return count;
+}
+
+
+bool CountingSink::flush(const Id * first, const Id * last)
+{
+	count += last - first;
+	return true;
+}
+
+
+BufferSink::BufferSink(Id * buffer, std::size_t capacity)
+	: ResultSink(buffer, capacity)
+{
+}
+
+
+std::size_t BufferSink::getSize() const
+{
+	return written;
+}
+
+
+bool BufferSink::flush(const Id * first, const Id * last)
+{
+	// The results are already in place. Flushing during the search means the
+	// buffer is full and another result is waiting, thus stop.
+	written += last - first;
+	return false;
+}
+
+}
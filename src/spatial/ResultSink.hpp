@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include "DataObject.hpp"
+#include "Results.hpp"
+
+namespace Spatial
+{
+
+/**
+ * Receives the results of a search.
+ *
+ * Indexes push ids one at a time into a buffer, which is handed to flush
+ * whenever it is full and once the search is done. Pushing is thus a plain
+ * store in the common case, while subclasses decide what to do with the
+ * results: store them, count them, stream them elsewhere or stop the search.
+ *
+ * A sink is not thread safe. Once flush has asked to stop, the sink stays
+ * stopped and further results are discarded.
+ */
+class ResultSink
+{
+	public:
+		using Id = DataObject::Id;
+
+		/** Size of the buffer used by the sinks owning one */
+		static constexpr std::size_t CHUNK_SIZE = 256;
+
+		ResultSink(Id * buffer, std::size_t capacity);
+		virtual ~ResultSink();
+
+		// Buffer would be shared
+		ResultSink(const ResultSink&) = delete;
+		ResultSink& operator=(const ResultSink&) = delete;
+
+
+		/**
+		 * Add a result.
+		 *
+		 * @param id Id of the matching object
+		 * @return False if the search should stop
+		 */
+		bool push(Id id)
+		{
+			if (size == capacity && !drain()) {
+				return false;
+			}
+
+			buffer[size++] = id;
+			return true;
+		}
+
+
+		/**
+		 * Add a range of results, e.g. collected by a single thread.
+		 *
+		 * @param first First result
+		 * @param last One past the last result
+		 * @return False if the search should stop
+		 */
+		bool append(const Id * first, const Id * last)
+		{
+			for (; first != last; ++first) {
+				if (!push(*first)) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+
+		/**
+		 * Flush the remaining results. Called once the search is done.
+		 */
+		void finish();
+
+
+		/**
+		 * @return True if the sink asked the search to stop
+		 */
+		bool isStopped() const;
+
+	protected:
+
+		/**
+		 * Receive a chunk of results.
+		 *
+		 * @param first First result in the chunk
+		 * @param last One past the last result in the chunk
+		 * @return False if the search should stop
+		 */
+		virtual bool flush(const Id * first, const Id * last) = 0;
+
+	private:
+		Id * buffer;
+		std::size_t capacity;
+		std::size_t size = 0;
+		bool stopped = false;
+
+		bool drain();
+};
+
+
+/**
+ * Appends the results to a result set.
+ */
+class VectorSink : public ResultSink
+{
+	public:
+		VectorSink(Results& results);
+
+	protected:
+		bool flush(const Id * first, const Id * last) override;
+
+	private:
+		Results& results;
+		Id chunk[CHUNK_SIZE];
+};
+
+
+/**
+ * Counts the results without storing them.
+ */
+class CountingSink : public ResultSink
+{
+	public:
+		CountingSink();
+
+		unsigned long long getCount() const;
+
+	protected:
+		bool flush(const Id * first, const Id * last) override;
+
+	private:
+		unsigned long long count = 0;
+		Id chunk[CHUNK_SIZE];
+};
+
+
+/**
+ * Writes the results directly into a preallocated buffer.
+ *
+ * The search is stopped when the buffer overflows, which is reported by
+ * isStopped.
+ */
+class BufferSink : public ResultSink
+{
+	public:
+		BufferSink(Id * buffer, std::size_t capacity);
+
+		/**
+		 * @return Number of results written to the buffer
+		 */
+		std::size_t getSize() const;
+
+	protected:
+		bool flush(const Id * first, const Id * last) override;
+
+	private:
+		std::size_t written = 0;
+};
+
+}
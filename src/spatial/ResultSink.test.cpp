@@ -0,0 +1,83 @@
+#include <criterion/criterion.h>
+#include "ResultSink.hpp"
+#include <vector>
+
+using namespace Spatial;
+
+
+Test(ResultSink, vector)
+{
+	Results results;
+	VectorSink sink (results);
+
+	// Enough results to flush a few chunks
+	for (DataObject::Id id = 0; id < 1000; ++id) {
+		cr_expect(sink.push(id), "Vector sink should never stop");
+	}
+
+	sink.finish();
+
+	cr_expect_eq(results.size(), 1000u, "All results should be appended");
+	cr_expect_eq(results[0], 0u, "Results should keep their order");
+	cr_expect_eq(results[999], 999u, "Results should keep their order");
+}
+
+
+Test(ResultSink, counting)
+{
+	CountingSink sink;
+
+	for (DataObject::Id id = 0; id < 1000; ++id) {
+		sink.push(id);
+	}
+
+	sink.finish();
+
+	cr_expect_eq(sink.getCount(), 1000u, "All results should be counted");
+}
+
+
+Test(ResultSink, buffer)
+{
+	std::vector<DataObject::Id> buffer (10);
+
+	BufferSink exact (buffer.data(), buffer.size());
+
+	for (DataObject::Id id = 0; id < 10; ++id) {
+		cr_expect(exact.push(id), "Buffer sink should accept results");
+	}
+
+	exact.finish();
+
+	cr_expect_eq(exact.getSize(), 10u, "Buffer should be filled");
+	cr_expect_not(exact.isStopped(), "Exactly filling should not overflow");
+	cr_expect_eq(buffer[9], 9u, "Results should be written in place");
+
+	BufferSink overflow (buffer.data(), buffer.size());
+
+	for (DataObject::Id id = 0; id < 10; ++id) {
+		overflow.push(100 + id);
+	}
+
+	cr_expect_not(overflow.push(110), "Overflow should stop the search");
+	cr_expect_not(overflow.push(111), "Stopped sink should stay stopped");
+
+	overflow.finish();
+
+	cr_expect_eq(overflow.getSize(), 10u, "Overflow should not be counted");
+	cr_expect(overflow.isStopped(), "Overflow should be reported");
+	cr_expect_eq(buffer[9], 109u, "Overflow should not overwrite results");
+
+	DataObject::Id chunk[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+	BufferSink appended (buffer.data(), buffer.size());
+
+	cr_expect_not(
+			appended.append(chunk, chunk + 12),
+			"Appending past the end should stop the search"
+		);
+
+	appended.finish();
+
+	cr_expect_eq(appended.getSize(), 10u, "Appended results should fit");
+	cr_expect_eq(buffer[0], 1u, "Appended results should be in order");
+}
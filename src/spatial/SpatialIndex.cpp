@@ -1,6 +1,10 @@
 #include "SpatialIndex.hpp"
+#include "ContainsQuery.hpp"
 #include "KnnQuery.hpp"
+#include "RadiusQuery.hpp"
 #include "RangeQuery.hpp"
+#include "StabbingQuery.hpp"
+#include "WithinQuery.hpp"
 #include <stdexcept>
 
 namespace Spatial
@@ -10,6 +14,35 @@ SpatialIndex::~SpatialIndex()
 {
 }
 
+void SpatialIndex::bulkLoad(const std::vector<DataObject>& objects)
+{
+	for (const DataObject& object : objects) {
+		insert(object);
+	}
+}
+
+
+bool SpatialIndex::remove(const DataObject&)
+{
+	throw std::runtime_error("This index does not support removal");
+}
+
+
+bool SpatialIndex::update(
+		DataObject::Id id,
+		const Box& oldBox,
+		const Box& newBox
+	)
+{
+	if (!remove(DataObject(id, oldBox))) {
+		return false;
+	}
+
+	insert(DataObject(id, newBox));
+	return true;
+}
+
+
 void SpatialIndex::checkStructure() const
 {
 }
@@ -21,25 +54,88 @@ StatsCollector SpatialIndex::collectStatistics() const
 }
 
 
+StatsCollector SpatialIndex::collectMemoryStatistics() const
+{
+	throw std::runtime_error("This index does not support memory statistics");
+}
+
+
 void SpatialIndex::prepare()
 {
 };
 
 
 void SpatialIndex::search(Results& results, const Query& query) const
+{
+	if (query.getType() == Query::Type::KNN) {
+		const KnnQuery * kq = static_cast<const KnnQuery *>(&query);
+		knnSearch(results, kq->k, kq->point);
+		return;
+	}
+
+	VectorSink sink (results);
+	search(sink, query);
+}
+
+
+void SpatialIndex::search(ResultSink& sink, const Query& query) const
 {
 	switch (query.getType()) {
 		case Query::Type::RANGE:
 		{
 			const RangeQuery * rq = static_cast<const RangeQuery *>(&query);
-			rangeSearch(results, rq->getBox());
+			rangeSearch(sink, rq->getBox());
+			sink.finish();
 			return;
 		}
 
 		case Query::Type::KNN:
 		{
+			// Only k results, thus no need to stream them
 			const KnnQuery * kq = static_cast<const KnnQuery *>(&query);
+			Results results;
 			knnSearch(results, kq->k, kq->point);
+
+			for (DataObject::Id id : results) {
+				if (!sink.push(id)) {
+					break;
+				}
+			}
+
+			sink.finish();
+			return;
+		}
+
+		case Query::Type::CONTAINS:
+		{
+			const ContainsQuery * cq = static_cast<const ContainsQuery *>(&query);
+			predicateSearch(sink, cq->getBox(), Predicate::CONTAINS);
+			sink.finish();
+			return;
+		}
+
+		case Query::Type::WITHIN:
+		{
+			const WithinQuery * wq = static_cast<const WithinQuery *>(&query);
+			predicateSearch(sink, wq->getBox(), Predicate::WITHIN);
+			sink.finish();
+			return;
+		}
+
+		case Query::Type::STAB:
+		{
+			// Objects containing a point are those intersecting it
+			const StabbingQuery * sq = static_cast<const StabbingQuery *>(&query);
+			rangeSearch(sink, Box(sq->point, sq->point));
+			sink.finish();
+			return;
+		}
+
+		case Query::Type::RADIUS:
+		{
+			const RadiusQuery * rq = static_cast<const RadiusQuery *>(&query);
+			radiusSearch(sink, rq->getBox(), rq->getRadius());
+			sink.finish();
 			return;
 		}
 	}
@@ -48,6 +144,46 @@ void SpatialIndex::search(Results& results, const Query& query) const
 }
 
 
+void SpatialIndex::searchBatch(
+		const std::vector<RangeQuery>& queries,
+		const std::vector<ResultSink *>& sinks
+	) const
+{
+	if (queries.size() != sinks.size()) {
+		throw std::invalid_argument("Need one sink for each query");
+	}
+
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		search(*sinks[i], queries[i]);
+	}
+}
+
+
+unsigned long long SpatialIndex::count(const Box& box) const
+{
+	CountingSink sink;
+	rangeSearch(sink, box);
+	sink.finish();
+
+	return sink.getCount();
+}
+
+
+void SpatialIndex::join(
+		PairSink& sink,
+		const SpatialIndex& other,
+		double distance
+	) const
+{
+	if (distance < 0.0) {
+		throw std::invalid_argument("Join distance must not be negative");
+	}
+
+	distanceJoin(sink, other, distance);
+	sink.finish();
+}
+
+
 void SpatialIndex::search(StatsCollector& stats, const Query& query) const
 {
 	switch (query.getType()) {
@@ -64,16 +200,91 @@ void SpatialIndex::search(StatsCollector& stats, const Query& query) const
 			knnSearch(stats, kq->k, kq->point);
 			return;
 		}
+
+		case Query::Type::STAB:
+		{
+			const StabbingQuery * sq = static_cast<const StabbingQuery *>(&query);
+			rangeSearch(stats, Box(sq->point, sq->point));
+			return;
+		}
+
+		case Query::Type::CONTAINS:
+		{
+			const ContainsQuery * cq = static_cast<const ContainsQuery *>(&query);
+			predicateSearch(stats, cq->getBox(), Predicate::CONTAINS);
+			return;
+		}
+
+		case Query::Type::WITHIN:
+		{
+			const WithinQuery * wq = static_cast<const WithinQuery *>(&query);
+			predicateSearch(stats, wq->getBox(), Predicate::WITHIN);
+			return;
+		}
+
+		case Query::Type::RADIUS:
+		{
+			const RadiusQuery * rq = static_cast<const RadiusQuery *>(&query);
+			radiusSearch(stats, rq->getBox(), rq->getRadius());
+			return;
+		}
 	}
 
 	throw std::runtime_error("Unknown query type");
 }
 
+void SpatialIndex::predicateSearch(
+		ResultSink& sink,
+		const Box& box,
+		Predicate predicate
+	) const
+{
+	if (predicate != Predicate::INTERSECTS) {
+		throw std::runtime_error("This index does not support containment");
+	}
+
+	rangeSearch(sink, box);
+}
+
+void SpatialIndex::radiusSearch(ResultSink&, const Box&, double) const
+{
+	throw std::runtime_error("This index does not support radius search");
+}
+
+void SpatialIndex::distanceJoin(
+		PairSink&,
+		const SpatialIndex&,
+		double
+	) const
+{
+	throw std::runtime_error("This index does not support joins");
+}
+
 void SpatialIndex::rangeSearch(StatsCollector& stats, const Box& box) const
 {
 	throw std::runtime_error("Range search instrumentation not implemented");
 }
 
+void SpatialIndex::predicateSearch(
+		StatsCollector& stats,
+		const Box& box,
+		Predicate predicate
+	) const
+{
+	if (predicate != Predicate::INTERSECTS) {
+		throw std::runtime_error(
+				"Containment search instrumentation not implemented"
+			);
+	}
+
+	rangeSearch(stats, box);
+}
+
+void SpatialIndex::radiusSearch(StatsCollector&, const Box&, double) const
+{
+	throw std::runtime_error("Radius search instrumentation not implemented");
+}
+
 void SpatialIndex::knnSearch(
 		StatsCollector&,
 		unsigned k,
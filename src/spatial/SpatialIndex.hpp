@@ -1,6 +1,10 @@
 #pragma once
 #include "Query.hpp"
+#include "PairSink.hpp"
+#include "Predicate.hpp"
+#include "RangeQuery.hpp"
 #include "Results.hpp"
+#include "ResultSink.hpp"
 #include "Box.hpp"
 #include "DataObject.hpp"
 #include "StatsCollector.hpp"
@@ -33,6 +37,48 @@ class SpatialIndex
 		virtual void insert(const DataObject& object) = 0;
 
 
+		/**
+		 * Load a complete data set into an empty index.
+		 *
+		 * Indexes able to build a better structure (or build it faster) when
+		 * all objects are known up front should override this. By default,
+		 * the objects are inserted one by one.
+		 *
+		 * @param objects Data objects to index
+		 */
+		virtual void bulkLoad(const std::vector<DataObject>& objects);
+
+
+		/**
+		 * Remove an object from the index.
+		 *
+		 * The object is identified by its id, while its box is used to find
+		 * it. Indexes without support for removal throw.
+		 *
+		 * @param object Data object to remove (as inserted)
+		 * @return True if the object was found and removed
+		 */
+		virtual bool remove(const DataObject& object);
+
+
+		/**
+		 * Move an object to a new box.
+		 *
+		 * By default, the object is removed and inserted again with the new
+		 * box. Indexes able to update objects in place should override this.
+		 *
+		 * @param id Id of the object to move
+		 * @param oldBox Current box of the object
+		 * @param newBox New box of the object
+		 * @return True if the object was found and updated
+		 */
+		virtual bool update(
+				DataObject::Id id,
+				const Box& oldBox,
+				const Box& newBox
+			);
+
+
 		/**
 		 * Check the structure of this index.
 		 *
@@ -53,6 +99,15 @@ class SpatialIndex
 		virtual StatsCollector collectStatistics() const;
 
 
+		/**
+		 * Collect statistics about the memory held by this index, such as
+		 * how much is reserved and how it is backed.
+		 *
+		 * @return Statistics about the memory of the index
+		 */
+		virtual StatsCollector collectMemoryStatistics() const;
+
+
 		/**
 		 * Prepare the index for searching.
 		 *
@@ -74,6 +129,69 @@ class SpatialIndex
 		void search(Results& results, const Query& query) const;
 
 
+		/**
+		 * Perform a search, streaming the results into a sink.
+		 *
+		 * The search stops early if the sink asks for it. The sink is
+		 * finished before returning.
+		 *
+		 * @param sink Sink receiving the results
+		 * @param query Query to use for searching
+		 */
+		void search(ResultSink& sink, const Query& query) const;
+
+
+		/**
+		 * Perform a batch of range searches.
+		 *
+		 * Indexes able to share work between the queries, e.g. by visiting
+		 * each node once for the whole batch, should override this. By
+		 * default, the queries are run one at a time. Every sink is finished
+		 * before returning.
+		 *
+		 * @param queries Range queries to run
+		 * @param sinks Sink receiving the results, one for each query
+		 */
+		virtual void searchBatch(
+				const std::vector<RangeQuery>& queries,
+				const std::vector<ResultSink *>& sinks
+			) const;
+
+
+		/**
+		 * Count the objects intersecting a box.
+		 *
+		 * Indexes keeping counts of their objects, e.g. per subtree, should
+		 * override this. By default, the results of a range search are
+		 * counted without storing them.
+		 *
+		 * @param box Box to count objects in
+		 * @return Number of objects intersecting box
+		 */
+		virtual unsigned long long count(const Box& box) const;
+
+
+		/**
+		 * Join this index with another index.
+		 *
+		 * Reports every pair of objects within a distance of each other, one
+		 * from each index, as the id in this index followed by the id in the
+		 * other. The distance between two objects is the distance between
+		 * the closest points of their boxes, thus a distance of 0 gives the
+		 * intersecting pairs. The join stops early if the sink asks for it.
+		 * The sink is finished before returning.
+		 *
+		 * @param sink Sink receiving the pairs
+		 * @param other Index to join with
+		 * @param distance Maximum distance between the objects of a pair
+		 */
+		void join(
+				PairSink& sink,
+				const SpatialIndex& other,
+				double distance = 0.0
+			) const;
+
+
 		/**
 		 * Performs an instrumeted search.
 		 *
@@ -88,10 +206,61 @@ class SpatialIndex
 
 	protected:
 		virtual void rangeSearch(
-				Results& r,
+				ResultSink& sink,
 				const Box& box
 			) const = 0;
 
+
+		/**
+		 * Search for the objects related to a box by a predicate.
+		 *
+		 * Used for containment queries. Intersection is handled by range
+		 * search, while indexes without support for the other predicates
+		 * throw.
+		 *
+		 * @param sink Sink receiving the results
+		 * @param box Query box
+		 * @param predicate Relation between the objects and the box
+		 */
+		virtual void predicateSearch(
+				ResultSink& sink,
+				const Box& box,
+				Predicate predicate
+			) const;
+
+		/**
+		 * Search for the objects within a distance of a box.
+		 *
+		 * Indexes without support for radius queries throw.
+		 *
+		 * @param sink Sink receiving the results
+		 * @param box Query box
+		 * @param radius Maximum distance between the objects and the box
+		 */
+		virtual void radiusSearch(
+				ResultSink& sink,
+				const Box& box,
+				double radius
+			) const;
+
+
+		/**
+		 * Report the pairs of objects within a distance of each other in
+		 * this and another index.
+		 *
+		 * Indexes able to join with (some) other indexes override this,
+		 * while the default throws.
+		 *
+		 * @param sink Sink receiving the pairs
+		 * @param other Index to join with
+		 * @param distance Maximum distance between the objects of a pair
+		 */
+		virtual void distanceJoin(
+				PairSink& sink,
+				const SpatialIndex& other,
+				double distance
+			) const;
+
 		virtual void knnSearch(
 				Results& r,
 				unsigned k,
@@ -103,6 +272,38 @@ class SpatialIndex
 				const Box& box
 			) const;
 
+		/**
+		 * Instrumented search for the objects related to a box by a
+		 * predicate.
+		 *
+		 * Intersection is handled by the instrumented range search, while
+		 * indexes without instrumentation for the other predicates throw.
+		 *
+		 * @param collector Object in which statistics should be recorded
+		 * @param box Query box
+		 * @param predicate Relation between the objects and the box
+		 */
+		virtual void predicateSearch(
+				StatsCollector& collector,
+				const Box& box,
+				Predicate predicate
+			) const;
+
+		/**
+		 * Instrumented search for the objects within a distance of a box.
+		 *
+		 * Indexes without instrumentation for radius queries throw.
+		 *
+		 * @param collector Object in which statistics should be recorded
+		 * @param box Query box
+		 * @param radius Maximum distance between the objects and the box
+		 */
+		virtual void radiusSearch(
+				StatsCollector& collector,
+				const Box& box,
+				double radius
+			) const;
+
 		virtual void knnSearch(
 				StatsCollector& collector,
 				unsigned k,
@@ -0,0 +1,21 @@
+#include "StabbingQuery.hpp"
+
+namespace Spatial
+{
+
+StabbingQuery::StabbingQuery(unsigned id, const Point& point)
+	: Query(Query::Type::STAB), point(point), id(id)
+{
+}
+
+std::string StabbingQuery::getName() const
+{
+	return std::to_string(id);
+}
+
+std::ostream& operator<<(std::ostream& stream, const StabbingQuery& query)
+{
+	return stream << "stab " << query.point;
+}
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "Query.hpp"
+
+namespace Spatial
+{
+
+/**
+ * Query for the objects containing a point.
+ */
+class StabbingQuery : public Query
+{
+	public:
+		const Point point;
+
+		StabbingQuery(unsigned id, const Point& point);
+
+		std::string getName() const;
+
+	private:
+		unsigned id;
+};
+
+std::ostream& operator<<(std::ostream& stream, const StabbingQuery& query);
+
+}
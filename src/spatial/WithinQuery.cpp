@@ -0,0 +1,27 @@
+#include "WithinQuery.hpp"
+
+namespace Spatial
+{
+
+WithinQuery::WithinQuery(unsigned id, const Box& box)
+	: Query(Query::Type::WITHIN), box(box), id(id)
+{
+}
+
+std::string WithinQuery::getName() const
+{
+	return std::to_string(id);
+}
+
+const Box& WithinQuery::getBox() const
+{
+	return box;
+}
+
+std::ostream& operator<<(std::ostream& stream, const WithinQuery& query)
+{
+	auto& points = query.getBox().getPoints();
+	return stream << "within " << points.first << ' ' << points.second;
+}
+
+}
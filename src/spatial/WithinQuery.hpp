@@ -0,0 +1,27 @@
+#pragma once
+#include "Box.hpp"
+#include "Query.hpp"
+
+namespace Spatial
+{
+
+/**
+ * Query for the objects lying within a box.
+ */
+class WithinQuery : public Query
+{
+	public:
+		WithinQuery(unsigned id, const Box& box);
+
+		std::string getName() const;
+		const Box& getBox() const;
+
+	private:
+		Box box;
+		unsigned id;
+
+};
+
+std::ostream& operator<<(std::ostream& stream, const WithinQuery& query);
+
+}